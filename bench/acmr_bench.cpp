@@ -0,0 +1,72 @@
+// Regression check: vertex cache optimization of the procedural sphere and heightmap grid. Reports
+// the ACMR (transformed vertices per triangle, FIFO cache of kVertexCacheSize) before and after
+// optimizeMesh and the time it took, and fails if the optimized order is not better than the
+// generator's or exceeds kMaxOptimizedACMR.
+//
+// Usage: bench_acmr
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HeightField.hpp"
+#include "MeshGenerators.hpp"
+#include "MeshOptimizer.hpp"
+
+// Tipsify reaches about 0.6 on these grids with a 16 entry cache; row order is about 1.0.
+constexpr float kMaxOptimizedACMR = 0.75f;
+
+static bool check(const std::string &name, std::vector<Vertex> vertices, std::vector<uint32_t> indices)
+{
+	const size_t triangles = indices.size() / 3;
+	const float before = computeACMR(indices, vertices.size());
+	auto start = std::chrono::steady_clock::now();
+	optimizeMesh(vertices, indices);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const float after = computeACMR(indices, vertices.size());
+
+	bool ok = after < before && after <= kMaxOptimizedACMR && indices.size() / 3 == triangles;
+	std::cout << std::setw(22) << std::left << name << std::right << std::setw(10) << triangles
+			  << std::fixed << std::setprecision(3) << std::setw(10) << before << std::setw(10) << after
+			  << std::setprecision(2) << std::setw(11) << ms << "  " << (ok ? "ok" : "FAIL") << "\n"
+			  << std::defaultfloat;
+	if (!ok)
+		std::cerr << name << ": optimized ACMR " << after << " must be below the input's " << before
+				  << " and at most " << kMaxOptimizedACMR << "\n";
+	return ok;
+}
+
+int main()
+{
+	std::cout << std::setw(22) << std::left << "mesh" << std::right << std::setw(10) << "triangles"
+			  << std::setw(10) << "ACMR in" << std::setw(10) << "ACMR out" << std::setw(11) << "opt ms" << "\n";
+	bool ok = true;
+
+	for (int segments : {32, 128})
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		generateSphere(segments, vertices, indices, 1);
+		ok &= check("sphere " + std::to_string(segments), std::move(vertices), std::move(indices));
+	}
+
+	for (int size : {64, 256})
+	{
+		// Rolling hills, so the grid is not flat (overdraw sorting looks at the normals).
+		std::vector<float> heights(static_cast<size_t>(size) * size);
+		for (int z = 0; z < size; ++z)
+			for (int x = 0; x < size; ++x)
+				heights[static_cast<size_t>(z) * size + x] = 0.5f + 0.25f * std::sin(x * 0.2f) * std::cos(z * 0.15f);
+		HeightField field(heights, size, size, 4.0f);
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		generateHeightGrid(field, vertices, indices, 1);
+		ok &= check("heightmap " + std::to_string(size) + "x" + std::to_string(size), std::move(vertices), std::move(indices));
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
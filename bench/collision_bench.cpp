@@ -0,0 +1,100 @@
+// Micro-benchmark: player-vs-wall collision queries through CollisionGrid against the
+// previous linear scan over every model, for mazes from 10x10 to 1000x1000 cells.
+//
+// Usage: bench_collision [maxSize]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "CollisionGrid.hpp"
+#include "Labyrinth.hpp"
+
+// The original App::checkObjectCollision loop.
+static bool linearOverlap(const std::vector<AABB> &walls, const AABB &player)
+{
+	for (const AABB &wall : walls)
+	{
+		if (player.max.x > wall.min.x && player.min.x < wall.max.x &&
+			player.max.y > wall.min.y && player.min.y < wall.max.y &&
+			player.max.z > wall.min.z && player.min.z < wall.max.z)
+			return true;
+	}
+	return false;
+}
+
+template <typename Query>
+static double nsPerQuery(const std::vector<AABB> &players, Query &&query, size_t &hits)
+{
+	hits = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (const AABB &player : players)
+		hits += query(player) ? 1 : 0;
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	return ns / players.size();
+}
+
+int main(int argc, char **argv)
+{
+	int maxSize = argc > 1 ? std::atoi(argv[1]) : 1000;
+	const glm::vec3 playerSize(0.2f, 0.9f, 0.2f);
+
+	std::cout << std::setw(6) << "cells" << std::setw(10) << "walls" << std::setw(12) << "build ms"
+			  << std::setw(14) << "grid ns/q" << std::setw(16) << "linear ns/q" << std::setw(10) << "speedup" << std::setw(8) << "hit %" << "\n";
+
+	for (int size : {10, 50, 100, 200, 500, 1000})
+	{
+		if (size > maxSize)
+			break;
+		std::vector<AABB> walls = labyrinthWallBoxes(makeLabyrinth(size), size, 1.0f);
+
+		auto buildStart = std::chrono::steady_clock::now();
+		CollisionGrid grid;
+		grid.build(walls, 1.0f);
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+		// Random player positions inside the maze; the linear scan gets fewer so it finishes.
+		std::mt19937 rng(42u);
+		std::uniform_real_distribution<float> coord(-size * 0.5f, size * 0.5f);
+		std::vector<AABB> players(200000);
+		for (AABB &player : players)
+		{
+			glm::vec3 p(coord(rng), 0.0f, coord(rng));
+			player = AABB{p - playerSize, p + playerSize};
+		}
+		size_t linearCount = std::max<size_t>(50, std::min<size_t>(players.size(), 50000000 / walls.size()));
+		std::vector<AABB> linearPlayers(players.begin(), players.begin() + linearCount);
+
+		size_t gridHits = 0, linearHits = 0;
+		double gridNs = nsPerQuery(players, [&](const AABB &p)
+								   { return grid.overlaps(p); }, gridHits);
+		double linearNs = nsPerQuery(linearPlayers, [&](const AABB &p)
+									 { return linearOverlap(walls, p); }, linearHits);
+
+		// Both must agree on the common prefix (this also keeps the timed loops from being optimized away).
+		size_t mismatches = 0, prefixHits = 0;
+		for (size_t i = 0; i < linearCount; ++i)
+		{
+			bool hit = grid.overlaps(players[i]);
+			prefixHits += hit ? 1 : 0;
+			mismatches += hit != linearOverlap(walls, players[i]);
+		}
+		if (mismatches != 0 || prefixHits != linearHits)
+		{
+			std::cerr << "Mismatch between grid and linear scan for " << size << "x" << size << "\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << std::setw(6) << size << std::setw(10) << walls.size() << std::setw(12) << std::fixed
+				  << std::setprecision(2) << buildMs << std::setw(14) << gridNs << std::setw(16) << linearNs
+				  << std::setw(9) << std::setprecision(0) << linearNs / gridNs << "x" << std::setw(8)
+				  << std::setprecision(1) << 100.0 * gridHits / players.size() << "\n";
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// Micro-benchmark: 1M random terrain height and normal queries through HeightField against the
+// previous Model::getHeightAt / getNormalAt (bilinear per call, normals from three height
+// lookups), plus the cost of building the field with its normals.
+//
+// Usage: bench_heightfield [queries]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "HeightField.hpp"
+
+// The original Model heightmap queries, kept verbatim (minus the type check) as the baseline.
+struct LegacyHeightmap
+{
+	float width;
+	float depth;
+	float heightScale;
+	std::vector<float> heightData;
+
+	float getHeightAt(float worldX, float worldZ) const
+	{
+		float u = (worldX / width) + 0.5f;
+		float v = (worldZ / depth) + 0.5f;
+		u = glm::clamp(u, 0.0f, 1.0f);
+		v = glm::clamp(v, 0.0f, 1.0f);
+		float xPos = u * width;
+		float zPos = v * depth;
+		int x0 = static_cast<int>(xPos);
+		int x1 = x0 + 1;
+		int z0 = static_cast<int>(zPos);
+		int z1 = z0 + 1;
+		x0 = glm::clamp(x0, 0, static_cast<int>(width) - 1);
+		x1 = glm::clamp(x1, 0, static_cast<int>(width) - 1);
+		z0 = glm::clamp(z0, 0, static_cast<int>(depth) - 1);
+		z1 = glm::clamp(z1, 0, static_cast<int>(depth) - 1);
+		float h00 = heightData[z0 * width + x0];
+		float h01 = heightData[z1 * width + x0];
+		float h10 = heightData[z0 * width + x1];
+		float h11 = heightData[z1 * width + x1];
+		float xFactor = xPos - x0;
+		float zFactor = zPos - z0;
+		float top = h00 * (1 - xFactor) + h10 * xFactor;
+		float bottom = h01 * (1 - xFactor) + h11 * xFactor;
+		return (top * (1 - zFactor) + bottom * zFactor) * heightScale;
+	}
+
+	glm::vec3 getNormalAt(float worldX, float worldZ) const
+	{
+		const float epsilon = 0.1f;
+		float height = getHeightAt(worldX, worldZ);
+		float dx = getHeightAt(worldX + epsilon, worldZ) - height;
+		float dz = getHeightAt(worldX, worldZ + epsilon) - height;
+		glm::vec3 tangent(1.0f, dx / epsilon, 0.0f);
+		glm::vec3 bitangent(0.0f, dz / epsilon, 1.0f);
+		return glm::normalize(glm::cross(tangent, bitangent));
+	}
+};
+
+// Rolling hills, so normals vary everywhere.
+static std::vector<float> makeTerrain(int size)
+{
+	std::vector<float> heights(static_cast<size_t>(size) * size);
+	for (int z = 0; z < size; ++z)
+		for (int x = 0; x < size; ++x)
+			heights[static_cast<size_t>(z) * size + x] =
+				0.5f + 0.25f * std::sin(x * 0.21f) * std::cos(z * 0.17f) + 0.25f * std::sin((x + z) * 0.05f);
+	return heights;
+}
+
+template <typename Query>
+static double nsPerQuery(const std::vector<glm::vec2> &points, Query &&query, float &checksum)
+{
+	checksum = 0.0f;
+	auto start = std::chrono::steady_clock::now();
+	for (const glm::vec2 &p : points)
+		checksum += query(p);
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	return ns / points.size();
+}
+
+int main(int argc, char **argv)
+{
+	size_t queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+	const float heightScale = 5.0f;
+
+	std::cout << std::setw(6) << "size" << std::setw(10) << "build ms" << std::setw(14) << "height ns/q"
+			  << std::setw(14) << "legacy ns/q" << std::setw(14) << "normal ns/q" << std::setw(14) << "legacy ns/q" << "\n";
+
+	for (int size : {50, 256, 1024, 4096})
+	{
+		std::vector<float> heights = makeTerrain(size);
+
+		auto buildStart = std::chrono::steady_clock::now();
+		HeightField field(heights, size, size, heightScale);
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+		LegacyHeightmap legacy{static_cast<float>(size - 1), static_cast<float>(size - 1), heightScale, heights};
+
+		std::mt19937 rng(7u);
+		std::uniform_real_distribution<float> coord(-size * 0.5f, size * 0.5f);
+		std::vector<glm::vec2> points(queries);
+		for (glm::vec2 &p : points)
+			p = glm::vec2(coord(rng), coord(rng));
+
+		float sums[4];
+		double heightNs = nsPerQuery(points, [&](const glm::vec2 &p)
+									 { return field.heightAt(p.x, p.y); }, sums[0]);
+		double legacyHeightNs = nsPerQuery(points, [&](const glm::vec2 &p)
+										   { return legacy.getHeightAt(p.x, p.y); }, sums[1]);
+		double normalNs = nsPerQuery(points, [&](const glm::vec2 &p)
+									 { return field.normalAt(p.x, p.y).y; }, sums[2]);
+		double legacyNormalNs = nsPerQuery(points, [&](const glm::vec2 &p)
+										   { return legacy.getNormalAt(p.x, p.y).y; }, sums[3]);
+
+		// The checksums keep the timed loops from being optimized away.
+		if (!std::isfinite(sums[0] + sums[1] + sums[2] + sums[3]))
+		{
+			std::cerr << "Non-finite query result for " << size << "x" << size << "\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << std::setw(6) << size << std::setw(10) << std::fixed << std::setprecision(2) << buildMs
+				  << std::setw(14) << heightNs << std::setw(14) << legacyHeightNs
+				  << std::setw(14) << normalNs << std::setw(14) << legacyNormalNs << "\n";
+	}
+	return EXIT_SUCCESS;
+}
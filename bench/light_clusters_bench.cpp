@@ -0,0 +1,109 @@
+// Scaling benchmark: clustered light culling for 3 to 1024 point lights scattered over a maze-sized
+// area, seen from a player standing inside it. Reports the CPU build time per frame and the
+// lights a fragment shades (clustered vs. every light), and checks that every light reaching a
+// sample point is in the list of the point's cluster.
+//
+// The in-app counterpart ("lights": {"benchmark": true} in app_settings.json) logs GPU frame times.
+//
+// Usage: bench_light_clusters [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "LightClusters.hpp"
+
+int main(int argc, char **argv)
+{
+	const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+	const int width = 1920, height = 1080;
+
+	// A 41x41 labyrinth floor, lights between the floor and the top of the walls.
+	AABB area{glm::vec3(-20.5f, -0.4f, -20.5f), glm::vec3(20.5f, 1.5f, 20.5f)};
+	const std::vector<ClusterLight> field = generateLightField(1024, area);
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(width) / height, 0.1f, 20000.0f);
+
+	LightClusters clusters;
+	clusters.setProjection(projection, width, height);
+
+	// Sample points: random pixels at random depths inside the area's depth range.
+	struct Sample
+	{
+		glm::vec3 world;
+		size_t cluster;
+	};
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::cout << std::setw(7) << "lights" << std::setw(12) << "build ms" << std::setw(12) << "refs"
+			  << std::setw(12) << "max/cluster" << std::setw(14) << "shaded/frag" << std::setw(10) << "saved" << "\n";
+	for (size_t count : {3, 8, 16, 32, 64, 128, 256, 512, 1024})
+	{
+		std::vector<ClusterLight> lights(field.begin(), field.begin() + count);
+
+		// The player walks a circle through the maze, so the view changes every frame.
+		double totalMs = 0.0;
+		glm::mat4 view(1.0f);
+		for (int f = 0; f < frames; ++f)
+		{
+			float angle = 6.2831853f * f / frames;
+			glm::vec3 eye(8.0f * std::cos(angle), 0.5f, 8.0f * std::sin(angle));
+			glm::vec3 forward(-std::sin(angle), 0.0f, std::cos(angle));
+			view = glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+
+			auto start = std::chrono::steady_clock::now();
+			clusters.build(view, lights);
+			totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// Check the last frame: a light reaching a point must be listed in the point's cluster.
+		const glm::mat4 inverseView = glm::inverse(view);
+		const glm::vec2 tile = clusters.tileSize();
+		const LightClusters::Settings &grid = clusters.config();
+		size_t shaded = 0, reaching = 0, samples = 20000;
+		for (size_t i = 0; i < samples; ++i)
+		{
+			float px = unit(rng) * width, py = unit(rng) * height;
+			float depth = 0.2f + unit(rng) * 40.0f;
+			glm::vec3 ndc(2.0f * px / width - 1.0f, 2.0f * py / height - 1.0f, 0.0f);
+			glm::vec3 viewPos(ndc.x * depth / projection[0][0], ndc.y * depth / projection[1][1], -depth);
+			glm::vec3 world = glm::vec3(inverseView * glm::vec4(viewPos, 1.0f));
+
+			int tx = std::min(static_cast<int>(px / tile.x), grid.tilesX - 1);
+			int ty = std::min(static_cast<int>(py / tile.y), grid.tilesY - 1);
+			int slice = std::clamp(static_cast<int>(std::log(depth) * clusters.sliceScale() + clusters.sliceBias()), 0, grid.slices - 1);
+			size_t cluster = (static_cast<size_t>(slice) * grid.tilesY + ty) * grid.tilesX + tx;
+			glm::uvec2 range = clusters.ranges()[cluster];
+			shaded += range.y;
+
+			for (size_t l = 0; l < lights.size(); ++l)
+			{
+				if (glm::length(lights[l].position - world) >= lights[l].range)
+					continue;
+				++reaching;
+				const uint32_t *first = clusters.indices().data() + range.x;
+				if (std::find(first, first + range.y, static_cast<uint32_t>(l)) == first + range.y)
+				{
+					std::cerr << "light " << l << " reaches a point of cluster " << cluster << " but is not listed\n";
+					return EXIT_FAILURE;
+				}
+			}
+		}
+
+		const LightClusters::Stats &stats = clusters.stats();
+		double perFragment = static_cast<double>(shaded) / samples;
+		std::cout << std::setw(7) << count << std::fixed << std::setprecision(3) << std::setw(12) << totalMs / frames
+				  << std::setw(12) << stats.references << std::setw(12) << stats.maxPerCluster
+				  << std::setprecision(2) << std::setw(14) << perFragment
+				  << std::setw(9) << static_cast<double>(count) / std::max(perFragment, 1e-3) << "x"
+				  << std::defaultfloat << "  (" << static_cast<double>(reaching) / samples << " reach)\n";
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+// Scaling benchmark: procedural sphere and heightmap grid generation on 1, 2, 4 and all hardware
+// threads. Every multi-threaded result is compared byte for byte with the single-threaded one.
+//
+// Usage: bench_meshgen [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MeshGenerators.hpp"
+#include "ParallelFor.hpp"
+
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	bool sameBytes(const MeshData &other) const
+	{
+		return vertices.size() == other.vertices.size() && indices.size() == other.indices.size() &&
+			   std::memcmp(vertices.data(), other.vertices.data(), vertices.size() * sizeof(Vertex)) == 0 &&
+			   std::memcmp(indices.data(), other.indices.data(), indices.size() * sizeof(uint32_t)) == 0;
+	}
+};
+
+using Generator = std::function<void(MeshData &, int threads)>;
+
+// Best of several runs, in milliseconds.
+static double bestMs(const Generator &generate, int threads, int repeats, MeshData &out)
+{
+	double best = 1e30;
+	for (int r = 0; r < repeats; ++r)
+	{
+		out = MeshData();
+		auto start = std::chrono::steady_clock::now();
+		generate(out, threads);
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	int repeats = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+	std::vector<int> threadCounts = {1, 2, 4};
+	if (defaultThreadCount() > 4)
+		threadCounts.push_back(defaultThreadCount());
+
+	struct Case
+	{
+		std::string name;
+		Generator generate;
+	};
+	std::vector<Case> cases;
+	for (int segments : {256, 1024, 2048})
+		cases.push_back({"sphere " + std::to_string(segments), [segments](MeshData &mesh, int threads)
+						 { generateSphere(segments, mesh.vertices, mesh.indices, threads); }});
+	for (int size : {512, 2048, 4096})
+	{
+		std::vector<float> heights(static_cast<size_t>(size) * size);
+		for (int z = 0; z < size; ++z)
+			for (int x = 0; x < size; ++x)
+				heights[static_cast<size_t>(z) * size + x] = 0.5f + 0.5f * std::sin(x * 0.013f) * std::cos(z * 0.017f);
+		auto field = std::make_shared<HeightField>(heights, size, size, 5.0f);
+		cases.push_back({"heightmap " + std::to_string(size), [field](MeshData &mesh, int threads)
+						 { generateHeightGrid(*field, mesh.vertices, mesh.indices, threads); }});
+	}
+
+	std::cout << std::setw(16) << "mesh";
+	for (int threads : threadCounts)
+		std::cout << std::setw(10) << (std::to_string(threads) + "T ms") << std::setw(9) << "speedup";
+	std::cout << "\n";
+
+	for (const Case &c : cases)
+	{
+		MeshData serial, parallel;
+		double serialMs = bestMs(c.generate, 1, repeats, serial);
+		std::cout << std::setw(16) << c.name << std::fixed << std::setprecision(2);
+		for (int threads : threadCounts)
+		{
+			double ms = threads == 1 ? serialMs : bestMs(c.generate, threads, repeats, parallel);
+			if (threads != 1 && !parallel.sameBytes(serial))
+			{
+				std::cerr << "\n"
+						  << c.name << ": output on " << threads << " threads differs from the serial output\n";
+				return EXIT_FAILURE;
+			}
+			std::cout << std::setw(10) << ms << std::setw(8) << serialMs / ms << "x";
+		}
+		std::cout << "\n";
+	}
+	return EXIT_SUCCESS;
+}
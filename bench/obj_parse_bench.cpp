@@ -0,0 +1,196 @@
+// Micro-benchmark: parse throughput of the memory-mapped loadOBJ against the
+// previous fscanf-based loader, on the bundled OBJ files. First checks loadOBJ on
+// a few small edge-case files and fails if any of them loads wrong.
+//
+// Usage: bench_obj_parse [file.obj ...]   (run from the repository root)
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "OBJloader.hpp"
+
+// The original loader, kept verbatim (minus diagnostics) as the baseline.
+static bool loadOBJ_fscanf(const char *path, std::vector<glm::vec3> &out_vertices, std::vector<glm::vec2> &out_uvs, std::vector<glm::vec3> &out_normals)
+{
+	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+	std::vector<glm::vec3> temp_vertices;
+	std::vector<glm::vec2> temp_uvs;
+	std::vector<glm::vec3> temp_normals;
+
+	out_vertices.clear();
+	out_uvs.clear();
+	out_normals.clear();
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return false;
+
+	while (1)
+	{
+		char lineHeader[255];
+		int res = fscanf(file, "%254s", lineHeader);
+		if (res == EOF)
+			break;
+
+		if (strcmp(lineHeader, "v") == 0)
+		{
+			glm::vec3 vertex;
+			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+			temp_vertices.push_back(vertex);
+		}
+		else if (strcmp(lineHeader, "vt") == 0)
+		{
+			glm::vec2 uv;
+			fscanf(file, "%f %f\n", &uv.y, &uv.x);
+			temp_uvs.push_back(uv);
+		}
+		else if (strcmp(lineHeader, "vn") == 0)
+		{
+			glm::vec3 normal;
+			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+			temp_normals.push_back(normal);
+		}
+		else if (strcmp(lineHeader, "f") == 0)
+		{
+			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
+			if (matches != 9)
+			{
+				fclose(file);
+				return false;
+			}
+			for (int i = 0; i < 3; ++i)
+			{
+				vertexIndices.push_back(vertexIndex[i]);
+				uvIndices.push_back(uvIndex[i]);
+				normalIndices.push_back(normalIndex[i]);
+			}
+		}
+	}
+
+	for (unsigned int u = 0; u < vertexIndices.size(); u++)
+		out_vertices.push_back(temp_vertices[vertexIndices[u] - 1]);
+	for (unsigned int u = 0; u < uvIndices.size(); u++)
+		out_uvs.push_back(temp_uvs[uvIndices[u] - 1]);
+	for (unsigned int u = 0; u < normalIndices.size(); u++)
+		out_normals.push_back(temp_normals[normalIndices[u] - 1]);
+
+	fclose(file);
+	return true;
+}
+
+using LoaderFn = bool (*)(const char *, std::vector<glm::vec3> &, std::vector<glm::vec2> &, std::vector<glm::vec3> &);
+
+// Runs the loader repeatedly for at least half a second; returns MB/s (or -1 if it fails).
+static double measure(LoaderFn loader, const std::string &path, double fileMB)
+{
+	std::vector<glm::vec3> vertices, normals;
+	std::vector<glm::vec2> uvs;
+
+	if (!loader(path.c_str(), vertices, uvs, normals))
+		return -1.0;
+
+	int iterations = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0.0;
+	do
+	{
+		loader(path.c_str(), vertices, uvs, normals);
+		++iterations;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < 0.5);
+
+	return fileMB * iterations / elapsed;
+}
+
+// Loads text as an OBJ file and compares the triangle count and the first corner's
+// position, uv (u in .y) and normal.
+static bool checkCase(const char *name, const std::string &text, size_t triangles, glm::vec3 position, glm::vec2 uv, glm::vec3 normal)
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "bench_obj_parse_case.obj";
+	{
+		std::ofstream out(path, std::ios::binary);
+		out << text;
+	}
+	std::vector<glm::vec3> vertices, normals;
+	std::vector<glm::vec2> uvs;
+	bool loaded = loadOBJ(path.string().c_str(), vertices, uvs, normals);
+	std::filesystem::remove(path);
+
+	auto near = [](float a, float b) { return std::abs(a - b) < 1e-5f; };
+	bool ok = loaded && vertices.size() == triangles * 3 && uvs.size() == vertices.size() && normals.size() == vertices.size();
+	ok = ok && near(vertices[0].x, position.x) && near(vertices[0].y, position.y) && near(vertices[0].z, position.z);
+	ok = ok && near(uvs[0].x, uv.x) && near(uvs[0].y, uv.y);
+	ok = ok && near(normals[0].x, normal.x) && near(normals[0].y, normal.y) && near(normals[0].z, normal.z);
+	if (!ok)
+		std::cerr << "Edge case failed: " << name << "\n";
+	return ok;
+}
+
+static bool checkEdgeCases()
+{
+	const std::string positions = "v 1 2 3\nv 4 5 6\nv 7 8 10\nv 0 0 1\n";
+	const glm::vec3 first(1.0f, 2.0f, 3.0f), up(0.0f, 0.0f, 1.0f);
+	bool ok = true;
+	ok &= checkCase("v/t/n", positions + "vt 0.25 0.75\nvn 0 0 1\nf 1/1/1 2/1/1 3/1/1\n", 1, first, glm::vec2(0.75f, 0.25f), up);
+	ok &= checkCase("vt with u only", positions + "vt 0.25\nvn 0 0 1\nf 1/1/1 2/1/1 3/1/1\n", 1, first, glm::vec2(0.0f, 0.25f), up);
+	ok &= checkCase("vt with u only, comment", positions + "vt 0.5 # u\nvn 0 0 1\nf 1/1/1 2/1/1 3/1/1\n", 1, first, glm::vec2(0.0f, 0.5f), up);
+	ok &= checkCase("vt with w", positions + "vt 0.25 0.75 1\nvn 0 0 1\nf 1/1/1 2/1/1 3/1/1\n", 1, first, glm::vec2(0.75f, 0.25f), up);
+	ok &= checkCase("CRLF", "v 1 2 3\r\nv 4 5 6\r\nv 7 8 10\r\nvt 0.25\r\nvn 0 0 1\r\nf 1/1/1 2/1/1 3/1/1\r\n", 1, first, glm::vec2(0.0f, 0.25f), up);
+	ok &= checkCase("v//n", positions + "vn 0 0 1\nf 1//1 2//1 3//1\n", 1, first, glm::vec2(0.0f), up);
+	ok &= checkCase("quad, negative indices", positions + "vt 0.25 0.75\nvn 0 0 1\nf -4/-1/-1 -3/-1/-1 -2/-1/-1 -1/-1/-1\n", 2, first, glm::vec2(0.75f, 0.25f), up);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	if (!checkEdgeCases())
+		return EXIT_FAILURE;
+
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+		files.push_back(argv[i]);
+	if (files.empty())
+		files = {"resources/objects/cube.obj", "resources/objects/triangle.obj",
+				 "resources/objects/sphere.obj", "resources/objects/sphere_tri_vnt.obj"};
+
+	std::cout << std::left << std::setw(42) << "file" << std::right << std::setw(10) << "KiB"
+			  << std::setw(14) << "fscanf MB/s" << std::setw(14) << "mmap MB/s" << std::setw(10) << "speedup" << "\n";
+
+	for (const auto &file : files)
+	{
+		std::error_code ec;
+		auto bytes = std::filesystem::file_size(file, ec);
+		if (ec)
+		{
+			std::cerr << "Cannot stat " << file << "\n";
+			continue;
+		}
+		double fileMB = bytes / (1024.0 * 1024.0);
+
+		double oldRate = measure(loadOBJ_fscanf, file, fileMB);
+		double newRate = measure(loadOBJ, file, fileMB);
+
+		std::cout << std::left << std::setw(42) << file << std::right << std::setw(10) << std::fixed << std::setprecision(1) << bytes / 1024.0;
+		if (oldRate < 0.0)
+			std::cout << std::setw(14) << "unsupported";
+		else
+			std::cout << std::setw(14) << oldRate;
+		std::cout << std::setw(14) << newRate;
+		if (oldRate > 0.0)
+			std::cout << std::setw(9) << newRate / oldRate << "x";
+		std::cout << "\n";
+	}
+	return 0;
+}
@@ -2,22 +2,29 @@
 in vec2 TexCoord;
 in vec3 FragPos;
 in vec3 Normal;
+flat in int TextureLayer;
 
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor; // Color, or weighted accumulation with uWeightedOIT.
+layout(location = 1) out float Revealage; // Weighted blended OIT only (OITBuffer).
 
-// Texture
+uniform bool uWeightedOIT = false;
+
+// Texture: a plain 2D texture, or a layer of a packed texture array (TextureLayer >= 0)
 uniform sampler2D textureSampler;
+layout(binding = 2) uniform sampler2DArray textureArray;
+
+// Sun shadow cascades (ShadowMaps), one layer each, compared in hardware
+layout(binding = 3) uniform sampler2DArrayShadow shadowMap;
 
-// Material
-struct Material {
+// Material (MaterialBuffer entry bound per mesh)
+layout(std140, binding = 2) uniform MaterialBlock {
     vec3 ambient;
+    float shininess;
     vec3 diffuse;
     vec3 specular;
-    float shininess;
-};
-uniform Material material;
+} material;
 
-// Light types
+// Light types (each vec3 is paired with a float to fill a std140 slot)
 struct DirLight {
     vec3 direction;
     vec3 ambient;
@@ -25,69 +32,96 @@ struct DirLight {
     vec3 specular;
 };
 
-struct PointLight {
+// Point or spot light (ClusterLight in LightClusters.hpp). Point lights have cone cosines below -1.
+struct ClusterLight {
     vec3 position;
+    float range;        // Cut-off distance, 0 = unbounded.
+    vec3 direction;
+    float cutOff;
     vec3 ambient;
+    float outerCutOff;
     vec3 diffuse;
-    vec3 specular;
     float constant;
+    vec3 specular;
     float linear;
     float quadratic;
 };
 
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+// Per-frame camera and lights (FrameUniformBuffer, shared by all programs)
+layout(std140, binding = 0) uniform CameraBlock {
+    mat4 uV_m;
+    mat4 uP_m;
+    vec3 viewPos;
 };
 
-// Lighting uniforms
-uniform DirLight dirLight;
-uniform PointLight pointLights[3];
-uniform SpotLight spotLight;
-uniform bool useSpotLight = false;
+layout(std140, binding = 1) uniform LightBlock {
+    DirLight dirLight;
+    uvec4 clusterGrid;       // Tiles in x, tiles in y, depth slices, lights.
+    vec2 clusterTileSize;    // Pixels.
+    float clusterSliceScale; // slice = log(view depth) * scale + bias.
+    float clusterSliceBias;
+    mat4 shadowMatrices[4];  // World -> shadow map coordinates and depth, per cascade.
+    vec4 cascadeSplits;      // View depth where each cascade ends.
+    vec4 cascadeTexelSizes;  // World size of a shadow texel, per cascade.
+    int shadowCascades;      // 0 = no shadows.
+    int shadowPcfRadius;     // (2r + 1)^2 taps.
+    float shadowTexelSize;   // 1 / shadow map resolution.
+};
 
-// Camera
-uniform vec3 viewPos;
+// Point and spot lights of the frame, bucketed into view-space clusters on the CPU (LightClusters)
+layout(std430, binding = 2) readonly buffer ClusterLights {
+    ClusterLight lights[];
+};
+layout(std430, binding = 3) readonly buffer ClusterRanges {
+    uvec2 clusterRanges[]; // {first, count} into clusterIndices
+};
+layout(std430, binding = 4) readonly buffer ClusterIndices {
+    uint clusterIndices[];
+};
 
 // Lighting calculation functions
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow);
+float ShadowFactor(vec3 normal, float viewDepth);
+vec3 CalcLight(ClusterLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+uint ClusterIndex(float viewDepth);
+float OITWeight(float viewDepth, float alpha);
 
 void main()
 {
     // Common calculations
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
+    float viewDepth = -(uV_m * vec4(FragPos, 1.0)).z;
     
     // Directional light (sun)
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, ShadowFactor(norm, viewDepth));
     
-    // Point lights
-    for(int i = 0; i < 3; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
-    
-    // Spot light
-    if(useSpotLight)
-        result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+    // Point and spot lights that reach this fragment's cluster
+    uvec2 range = clusterRanges[ClusterIndex(viewDepth)];
+    for (uint i = 0u; i < range.y; i++)
+        result += CalcLight(lights[clusterIndices[range.x + i]], norm, FragPos, viewDir);
     
     // Texture color
     // Default to white if no texture
     vec4 texColor = vec4(1.0);
-    if (textureSize(textureSampler, 0).x > 1) { // Check if texture exists
+    if (TextureLayer >= 0) {
+        texColor = texture(textureArray, vec3(TexCoord, float(TextureLayer)));
+    } else if (textureSize(textureSampler, 0).x > 1) { // Check if texture exists
         texColor = texture(textureSampler, TexCoord);
     }
     
-    FragColor = vec4(result, 1.0) * texColor;
+    vec4 color = vec4(result, 1.0) * texColor;
+    if (uWeightedOIT) {
+        // Premultiplied color and alpha, weighted so nearer surfaces dominate the average
+        FragColor = vec4(color.rgb * color.a, color.a) * OITWeight(viewDepth, color.a);
+        Revealage = color.a;
+    } else {
+        FragColor = color;
+    }
 }
 
 // Directional light calculation
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow)
 {
     vec3 lightDir = normalize(-light.direction);
     // Diffuse
@@ -99,11 +133,50 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     vec3 ambient = light.ambient * material.ambient;
     vec3 diffuse = light.diffuse * (diff * material.diffuse);
     vec3 specular = light.specular * (spec * material.specular);
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
+}
+
+// Fraction of the sun reaching the fragment: 1 = lit, 0 = shadowed
+float ShadowFactor(vec3 normal, float viewDepth)
+{
+    if (shadowCascades <= 0 || viewDepth >= cascadeSplits[shadowCascades - 1])
+        return 1.0;
+    int cascade = 0;
+    while (cascade < shadowCascades - 1 && viewDepth >= cascadeSplits[cascade])
+        cascade++;
+    // Normal offset of about a texel against acne on surfaces at grazing angles to the sun
+    vec3 position = FragPos + normal * (cascadeTexelSizes[cascade] * 1.5);
+    vec4 shadowCoord = shadowMatrices[cascade] * vec4(position, 1.0);
+    // Filtered comparisons over a (2r + 1)^2 texel neighbourhood
+    float lit = 0.0;
+    for (int y = -shadowPcfRadius; y <= shadowPcfRadius; y++) {
+        for (int x = -shadowPcfRadius; x <= shadowPcfRadius; x++) {
+            vec2 offset = vec2(x, y) * shadowTexelSize;
+            lit += texture(shadowMap, vec4(shadowCoord.xy + offset, float(cascade), shadowCoord.z));
+        }
+    }
+    float taps = float((2 * shadowPcfRadius + 1) * (2 * shadowPcfRadius + 1));
+    return lit / taps;
+}
+
+// Cluster of the fragment: screen tile from gl_FragCoord, slice from the view depth
+uint ClusterIndex(float viewDepth)
+{
+    float depth = max(viewDepth, 1e-4);
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterGrid.xy - 1u);
+    uint slice = uint(clamp(log(depth) * clusterSliceScale + clusterSliceBias, 0.0, float(clusterGrid.z - 1u)));
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
 }
 
-// Point light calculation
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+// Depth weight of weighted blended OIT (McGuire and Bavoil, equation 10)
+float OITWeight(float viewDepth, float alpha)
+{
+    float z = max(viewDepth, 0.0);
+    return alpha * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);
+}
+
+// Point or spot light calculation
+vec3 CalcLight(ClusterLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // Diffuse
@@ -111,33 +184,23 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // Specular
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // Attenuation
+    // Attenuation, faded to zero at the cut-off range so cluster borders do not show
     float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + 
+    float attenuation = 1.0 / (light.constant + light.linear * distance +
                       light.quadratic * (distance * distance));
+    if (light.range > 0.0) {
+        float fade = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+        attenuation *= fade * fade;
+    }
+    // Spot cone (point lights have cosines below -1)
+    if (light.outerCutOff >= -1.0) {
+        float theta = dot(lightDir, normalize(-light.direction));
+        float epsilon = light.cutOff - light.outerCutOff;
+        attenuation *= clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    }
     // Combine
     vec3 ambient = light.ambient * material.ambient;
     vec3 diffuse = light.diffuse * (diff * material.diffuse);
     vec3 specular = light.specular * (spec * material.specular);
     return (ambient + diffuse + specular) * attenuation;
 }
-
-// Spot light calculation
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    float theta = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    
-    // Diffuse
-    float diff = max(dot(normal, lightDir), 0.0);
-    // Specular
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // Combine
-    vec3 ambient = light.ambient * material.ambient;
-    vec3 diffuse = light.diffuse * (diff * material.diffuse);
-    vec3 specular = light.specular * (spec * material.specular);
-    return (ambient + diffuse + specular) * intensity;
-}
\ No newline at end of file
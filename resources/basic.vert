@@ -6,18 +6,43 @@ layout (location = 2) in vec3 attribute_Normal;
 out vec2 TexCoord;
 out vec3 FragPos;
 out vec3 Normal;
+flat out int TextureLayer; // Layer of textureArray, -1 for textureSampler.
+
+// Must match depth.vert exactly for the GL_EQUAL test after the depth pre-pass.
+invariant gl_Position;
+
+// Per-frame camera data (FrameUniformBuffer, shared by all programs).
+layout(std140, binding = 0) uniform CameraBlock
+{
+    mat4 uV_m;
+    mat4 uP_m;
+    vec3 viewPos;
+};
 
-uniform mat4 uP_m = mat4(1.0);
 uniform mat4 uM_m = mat4(1.0);
-uniform mat4 uV_m = mat4(1.0);
+
+// Per-instance model matrices, used instead of uM_m for instanced draws.
+layout(std430, binding = 0) readonly buffer InstanceMatrices
+{
+    mat4 instanceModel[];
+};
+uniform bool uInstanced = false;
+
+// Texture array layer per instance (instanced draws) or for the whole draw.
+layout(std430, binding = 1) readonly buffer InstanceLayers
+{
+    int instanceLayer[];
+};
+uniform int uTextureLayer = -1;
 
 void main()
 {
-    mat4 modelMatrix = uM_m;
+    mat4 modelMatrix = uInstanced ? instanceModel[gl_BaseInstance + gl_InstanceID] : uM_m;
     mat4 viewMatrix = uV_m;
     mat4 projectionMatrix = uP_m;
     gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(attribute_Position, 1.0);
     TexCoord = attribute_TexCoords;
     FragPos = vec3(modelMatrix * vec4(attribute_Position, 1.0));
     Normal = mat3(transpose(inverse(modelMatrix))) * (attribute_Normal);
+    TextureLayer = uInstanced ? instanceLayer[gl_BaseInstance + gl_InstanceID] : uTextureLayer;
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 460 core
+// Depth pre-pass: depth only, color writes are masked off.
+
+void main()
+{
+}
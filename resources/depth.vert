@@ -0,0 +1,29 @@
+#version 460 core
+// Depth pre-pass: positions only (GeometryResource::depthVAO). gl_Position must come out bit-identical
+// to basic.vert's so the shading pass can test with GL_EQUAL, hence the same expression and invariant.
+layout (location = 0) in vec3 attribute_Position;
+
+invariant gl_Position;
+
+layout(std140, binding = 0) uniform CameraBlock
+{
+    mat4 uV_m;
+    mat4 uP_m;
+    vec3 viewPos;
+};
+
+uniform mat4 uM_m = mat4(1.0);
+
+layout(std430, binding = 0) readonly buffer InstanceMatrices
+{
+    mat4 instanceModel[];
+};
+uniform bool uInstanced = false;
+
+void main()
+{
+    mat4 modelMatrix = uInstanced ? instanceModel[gl_BaseInstance + gl_InstanceID] : uM_m;
+    mat4 viewMatrix = uV_m;
+    mat4 projectionMatrix = uP_m;
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(attribute_Position, 1.0);
+}
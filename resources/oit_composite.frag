@@ -0,0 +1,24 @@
+#version 460 core
+// Weighted blended OIT resolve (see OITBuffer.hpp): average transparent color with coverage
+// 1 - revealage, blended over the opaque scene with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA.
+
+layout(binding = 0) uniform sampler2D accumTexture;
+layout(binding = 1) uniform sampler2D revealageTexture;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealageTexture, texel, 0).r;
+    if (revealage >= 1.0)
+        discard; // No transparent surface here.
+
+    vec4 accum = texelFetch(accumTexture, texel, 0);
+    // Keep the average finite when the half-float sum overflowed.
+    if (isinf(max(max(abs(accum.r), abs(accum.g)), abs(accum.b))))
+        accum.rgb = vec3(accum.a);
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+
+    FragColor = vec4(average, 1.0 - revealage);
+}
@@ -0,0 +1,17 @@
+#version 460 core
+// Shadow casters: positions only (GeometryResource::depthVAO), always instanced through
+// RenderQueue::flushDepth, projected into the cascade set by ShadowMaps::begin. Paired with depth.frag.
+layout (location = 0) in vec3 attribute_Position;
+
+layout(std430, binding = 0) readonly buffer InstanceMatrices
+{
+    mat4 instanceModel[];
+};
+
+uniform mat4 uLightViewProjection;
+
+void main()
+{
+    mat4 modelMatrix = instanceModel[gl_BaseInstance + gl_InstanceID];
+    gl_Position = uLightViewProjection * modelMatrix * vec4(attribute_Position, 1.0);
+}
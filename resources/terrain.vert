@@ -0,0 +1,78 @@
+#version 460 core
+// Attribute-less terrain chunk vertex: the position comes from gl_VertexID (see Terrain::buildIndices)
+// and the height from the chunk's layer of the R16 tile atlas, so no vertex buffers are needed.
+
+out vec2 TexCoord;
+out vec3 FragPos;
+out vec3 Normal;
+flat out int TextureLayer; // Layer of textureArray, -1 for textureSampler.
+
+// Per-frame camera data (FrameUniformBuffer, shared by all programs).
+layout(std140, binding = 0) uniform CameraBlock
+{
+    mat4 uV_m;
+    mat4 uP_m;
+    vec3 viewPos;
+};
+
+uniform mat4 uM_m = mat4(1.0);
+
+// Quantized height tiles (unit 1), normalized to [0, 1] by the texture format. Texel (0, 0) of a
+// tile is the sample at uChunkBase - 1, so the normals' neighbours are in the tile too.
+layout(binding = 1) uniform sampler2DArray heightSampler;
+
+uniform ivec2 uChunkBase;   // Sample of the chunk's first grid vertex.
+uniform int uTileLayer;     // The chunk's layer of heightSampler.
+uniform int uChunkQuads;
+uniform ivec2 uGridSize;    // Samples in x and z.
+uniform float uSpacing;     // World distance between samples.
+uniform float uHeightOffset; // World height = uHeightOffset + texel * uHeightRange.
+uniform float uHeightRange;
+uniform float uSkirtDepth;
+uniform vec2 uTexScale;     // Texture coordinates per sample.
+uniform int uTextureLayer = -1;
+
+float heightAt(ivec2 cell)
+{
+    return uHeightOffset + texelFetch(heightSampler, ivec3(cell - uChunkBase + 1, uTileLayer), 0).r * uHeightRange;
+}
+
+void main()
+{
+    // Grid vertices row by row, then the four skirts (z = 0, z = quads, x = 0, x = quads edges).
+    int side = uChunkQuads + 1;
+    int id = gl_VertexID;
+    bool skirt = id >= side * side;
+    ivec2 local;
+    if (!skirt)
+    {
+        local = ivec2(id % side, id / side);
+    }
+    else
+    {
+        int edge = (id - side * side) / side;
+        int t = (id - side * side) % side;
+        local = edge == 0 ? ivec2(t, 0)
+              : edge == 1 ? ivec2(t, uChunkQuads)
+              : edge == 2 ? ivec2(0, t)
+                          : ivec2(uChunkQuads, t);
+    }
+    // Samples past the map edge repeat the border (degenerate, invisible triangles).
+    ivec2 cell = min(uChunkBase + local, uGridSize - 1);
+
+    vec2 planar = (vec2(cell) - vec2(uGridSize - 1) * 0.5) * uSpacing;
+    float height = heightAt(cell) - (skirt ? uSkirtDepth : 0.0);
+    vec3 position = vec3(planar.x, height, planar.y);
+
+    // Central differences, one-sided at the borders.
+    ivec2 lo = max(cell - 1, ivec2(0));
+    ivec2 hi = min(cell + 1, uGridSize - 1);
+    float gx = hi.x > lo.x ? (heightAt(ivec2(hi.x, cell.y)) - heightAt(ivec2(lo.x, cell.y))) / (float(hi.x - lo.x) * uSpacing) : 0.0;
+    float gz = hi.y > lo.y ? (heightAt(ivec2(cell.x, hi.y)) - heightAt(ivec2(cell.x, lo.y))) / (float(hi.y - lo.y) * uSpacing) : 0.0;
+
+    gl_Position = uP_m * uV_m * uM_m * vec4(position, 1.0);
+    TexCoord = vec2(cell) * uTexScale;
+    FragPos = vec3(uM_m * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(uM_m))) * normalize(vec3(-gx, 1.0, -gz));
+    TextureLayer = uTextureLayer;
+}
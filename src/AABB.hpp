@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+// Axis-aligned bounding box. A default-constructed box is empty (min > max).
+struct AABB
+{
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+
+    bool empty() const { return min.x > max.x; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3 &point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const AABB &other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool operator==(const AABB &other) const { return min == other.min && max == other.max; }
+    bool operator!=(const AABB &other) const { return !(*this == other); }
+
+    // Box enclosing this box after an affine transform (Arvo: |M| applied to the extents).
+    AABB transformed(const glm::mat4 &m) const
+    {
+        if (empty())
+            return *this;
+        glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+        glm::vec3 e = extents();
+        glm::vec3 r = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y + glm::abs(glm::vec3(m[2])) * e.z;
+        return {c - r, c + r};
+    }
+};
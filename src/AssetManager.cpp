@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "AssetManager.hpp"
+#include "MeshCache.hpp"
+#include "TextureStreamer.hpp"
+
+GeometryResource::~GeometryResource()
+{
+	if (EBO != 0)
+		glDeleteBuffers(1, &EBO);
+	if (VBO != 0)
+		glDeleteBuffers(1, &VBO);
+	if (positionVBO != 0)
+		glDeleteBuffers(1, &positionVBO);
+	if (VAO != 0)
+		glDeleteVertexArrays(1, &VAO);
+	if (depthVAO != 0)
+		glDeleteVertexArrays(1, &depthVAO);
+}
+
+TextureResource::~TextureResource()
+{
+	if (id != 0 && !pending)
+		glDeleteTextures(1, &id);
+}
+
+TextureArrayResource::~TextureArrayResource()
+{
+	if (id != 0)
+		glDeleteTextures(1, &id);
+}
+
+AssetManager::AssetManager() : streamer(std::make_unique<TextureStreamer>()) {}
+
+AssetManager::~AssetManager() = default;
+
+AssetManager &AssetManager::instance()
+{
+	static AssetManager manager;
+	return manager;
+}
+
+GeometryHandle AssetManager::loadMesh(const std::filesystem::path &path, GLuint program)
+{
+	std::string key = path.lexically_normal().generic_string() + "|" + std::to_string(program);
+	++meshUsage.requests;
+
+	if (GeometryHandle existing = meshes[key].lock())
+	{
+		meshUsage.requestedBytes += existing->bytes;
+		return existing;
+	}
+
+	// Load the welded, cache-optimized mesh (parsed from the OBJ only when the cache is stale).
+	MeshCache cached;
+	if (!cached.open(path))
+	{
+		std::cerr << "Error: Failed to load OBJ file: " << path << "\n";
+		throw std::runtime_error("OBJ loading failed");
+	}
+
+	GeometryHandle geometry = createGeometry(program, cached.vertices(), cached.vertexCount(),
+											 cached.indices(), cached.indexCount(),
+											 cached.shortIndices() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+	meshes[key] = geometry;
+	++meshUsage.created;
+	meshUsage.requestedBytes += geometry->bytes;
+	meshUsage.createdBytes += geometry->bytes;
+	return geometry;
+}
+
+TextureHandle AssetManager::loadTexture(const std::string &path, const TextureParams &params)
+{
+	std::ostringstream key;
+	key << path << '|' << params.wrap << '|' << params.minFilter << '|' << params.magFilter;
+	++textureUsage.requests;
+
+	TextureEntry &entry = textures[key.str()];
+	if (TextureHandle existing = entry.texture.lock())
+	{
+		++entry.requests;
+		return existing;
+	}
+
+	TextureHandle texture = createTexture(path, params);
+	entry = {texture, 1, params};
+	++textureUsage.created;
+	return texture;
+}
+
+void AssetManager::updateTextures()
+{
+	// Pack and report again once the last image arrived; the startup report only had placeholders.
+	if (streamer->update())
+	{
+		packTextures();
+		printReport();
+	}
+}
+
+size_t AssetManager::packTextures()
+{
+	// Group the loaded, unpacked textures by everything an array's layers must share.
+	std::map<std::tuple<int, int, GLenum, GLsizei, GLenum, GLenum, GLenum>, std::vector<TextureHandle>> groups;
+	for (const auto &[key, entry] : textures)
+	{
+		TextureHandle texture = entry.texture.lock();
+		if (!texture || texture->pending || texture->array || texture->width <= 1 || texture->height <= 1)
+			continue;
+		groups[{texture->width, texture->height, texture->format, texture->levels,
+				entry.params.wrap, entry.params.minFilter, entry.params.magFilter}]
+			.push_back(texture);
+	}
+
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	size_t packed = 0, arrays = 0;
+	for (const auto &[key, members] : groups)
+	{
+		const auto &[width, height, format, levels, wrap, minFilter, magFilter] = key;
+		for (size_t first = 0; first + 1 < members.size(); first += static_cast<size_t>(maxLayers))
+		{
+			const size_t count = std::min(members.size() - first, static_cast<size_t>(maxLayers));
+			auto array = std::make_shared<TextureArrayResource>();
+			array->layers = static_cast<int>(count);
+			glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &array->id);
+			glTextureParameteri(array->id, GL_TEXTURE_WRAP_S, wrap);
+			glTextureParameteri(array->id, GL_TEXTURE_WRAP_T, wrap);
+			glTextureParameteri(array->id, GL_TEXTURE_MIN_FILTER, minFilter);
+			glTextureParameteri(array->id, GL_TEXTURE_MAG_FILTER, magFilter);
+			glTextureStorage3D(array->id, levels, format, width, height, array->layers);
+
+			// Copy every level on the GPU, then drop the 2D texture.
+			for (size_t i = 0; i < count; ++i)
+			{
+				TextureResource &texture = *members[first + i];
+				for (GLint level = 0; level < levels; ++level)
+				{
+					glCopyImageSubData(texture.id, GL_TEXTURE_2D, level, 0, 0, 0, array->id, GL_TEXTURE_2D_ARRAY, level,
+									   0, 0, static_cast<GLint>(i), std::max(width >> level, 1), std::max(height >> level, 1), 1);
+				}
+				glDeleteTextures(1, &texture.id);
+				texture.id = 0;
+				texture.array = array;
+				texture.layer = static_cast<int>(i);
+			}
+			packed += count;
+			++arrays;
+		}
+	}
+	if (packed > 0)
+		std::cout << "Texture arrays: packed " << packed << " textures into " << arrays << " arrays\n";
+	return packed;
+}
+
+void AssetManager::clear()
+{
+	streamer->clear();
+	placeholder.reset();
+}
+
+GeometryHandle AssetManager::createGeometry(GLuint program, const Vertex *vertexData, size_t vertexCount,
+											const void *indexData, size_t indexCount, GLenum indexType)
+{
+	auto geometry = std::make_shared<GeometryResource>();
+
+	// Create Vertex Array Object (VAO).
+	glCreateVertexArrays(1, &geometry->VAO);
+	if (geometry->VAO == 0)
+	{
+		std::cerr << "Error: Failed to create VAO\n";
+		throw std::runtime_error("VAO creation failed");
+	}
+
+	// Validate shader program.
+	if (program == 0)
+	{
+		std::cerr << "Error: Invalid shader program ID\n";
+		throw std::runtime_error("Invalid shader program");
+	}
+
+	// Configure position attribute.
+	GLint position_attrib_location = glGetAttribLocation(program, "attribute_Position");
+	if (position_attrib_location == -1)
+	{
+		std::cerr << "Error: Shader lacks 'attribute_Position'\n";
+		throw std::runtime_error("Invalid position attribute");
+	}
+	glEnableVertexArrayAttrib(geometry->VAO, position_attrib_location);
+	glVertexArrayAttribFormat(geometry->VAO, position_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+	glVertexArrayAttribBinding(geometry->VAO, position_attrib_location, 0);
+
+	// Configure normal attribute if used by shader.
+	GLint normal_attrib_location = glGetAttribLocation(program, "attribute_Normal");
+	if (normal_attrib_location != -1)
+	{
+		glEnableVertexArrayAttrib(geometry->VAO, normal_attrib_location);
+		glVertexArrayAttribFormat(geometry->VAO, normal_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+		glVertexArrayAttribBinding(geometry->VAO, normal_attrib_location, 0);
+	}
+
+	// Configure texture coordinate attribute if used by shader.
+	GLint texcoord_attrib_location = glGetAttribLocation(program, "attribute_TexCoords");
+	if (texcoord_attrib_location != -1)
+	{
+		glEnableVertexArrayAttrib(geometry->VAO, texcoord_attrib_location);
+		glVertexArrayAttribFormat(geometry->VAO, texcoord_attrib_location, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+		glVertexArrayAttribBinding(geometry->VAO, texcoord_attrib_location, 0);
+	}
+
+	// Create and upload Vertex Buffer Object (VBO).
+	glCreateBuffers(1, &geometry->VBO);
+	if (geometry->VBO == 0)
+	{
+		std::cerr << "Error: Failed to create VBO\n";
+		throw std::runtime_error("VBO creation failed");
+	}
+	size_t vertexBytes = vertexCount * sizeof(Vertex);
+	glNamedBufferData(geometry->VBO, vertexBytes, vertexData, GL_STATIC_DRAW);
+
+	// Create and upload Element Buffer Object (EBO).
+	glCreateBuffers(1, &geometry->EBO);
+	if (geometry->EBO == 0)
+	{
+		std::cerr << "Error: Failed to create EBO\n";
+		throw std::runtime_error("EBO creation failed");
+	}
+	size_t indexBytes = indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+	glNamedBufferData(geometry->EBO, indexBytes, indexData, GL_STATIC_DRAW);
+
+	// Link VBO and EBO to VAO.
+	glVertexArrayVertexBuffer(geometry->VAO, 0, geometry->VBO, 0, sizeof(Vertex));
+	glVertexArrayElementBuffer(geometry->VAO, geometry->EBO);
+
+	// Positions again, packed, for depth-only passes (12 instead of 32 bytes fetched per vertex).
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+		positions[i] = vertexData[i].Position;
+	size_t positionBytes = vertexCount * sizeof(glm::vec3);
+	glCreateBuffers(1, &geometry->positionVBO);
+	glNamedBufferData(geometry->positionVBO, positionBytes, positions.data(), GL_STATIC_DRAW);
+	glCreateVertexArrays(1, &geometry->depthVAO);
+	glEnableVertexArrayAttrib(geometry->depthVAO, 0);
+	glVertexArrayAttribFormat(geometry->depthVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(geometry->depthVAO, 0, 0);
+	glVertexArrayVertexBuffer(geometry->depthVAO, 0, geometry->positionVBO, 0, sizeof(glm::vec3));
+	glVertexArrayElementBuffer(geometry->depthVAO, geometry->EBO);
+
+	geometry->index_type = indexType;
+	geometry->index_count = static_cast<GLsizei>(indexCount);
+	geometry->vertex_count = vertexCount;
+	geometry->bytes = vertexBytes + positionBytes + indexBytes;
+
+	// Object-space bounds for culling.
+	for (const glm::vec3 &position : positions)
+		geometry->bounds.expand(position);
+	return geometry;
+}
+
+TextureHandle AssetManager::createTexture(const std::string &path, const TextureParams &params)
+{
+	auto texture = std::make_shared<TextureResource>();
+
+	if (path == "NONE" || path.empty())
+	{
+		// Create a 1x1 yellow ("NONE") or white (no path) texture.
+		unsigned char yellow[] = {255, 255, 0, 255};
+		unsigned char white[] = {255, 255, 255, 255};
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture->id);
+		glTextureStorage2D(texture->id, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(texture->id, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, path.empty() ? white : yellow);
+		glTextureParameteri(texture->id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(texture->id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		texture->width = texture->height = 1;
+		texture->bytes = 4;
+		return texture;
+	}
+
+	// Images are decoded and uploaded in the background; show the placeholder meanwhile.
+	if (!placeholder)
+		placeholder = createTexture("", TextureParams());
+	texture->id = placeholder->id;
+	texture->width = texture->height = 1;
+	texture->pending = true;
+	streamer->request(path, params, texture);
+	return texture;
+}
+
+void AssetManager::printReport() const
+{
+	auto print = [](const char *what, const Usage &usage)
+	{
+		std::cout << "  " << what << ": " << usage.requests << " requests -> " << usage.created << " GPU objects, "
+				  << usage.createdBytes / 1024 << " KiB resident, "
+				  << (usage.requestedBytes - usage.createdBytes) / 1024 << " KiB saved by sharing\n";
+	};
+	Usage textureTotals = textureUsage;
+	size_t loading = 0;
+	for (const auto &[key, entry] : textures)
+	{
+		if (TextureHandle texture = entry.texture.lock())
+		{
+			textureTotals.createdBytes += texture->bytes;
+			textureTotals.requestedBytes += texture->bytes * entry.requests;
+			loading += texture->pending ? 1 : 0;
+		}
+	}
+	std::cout << "Asset registry:\n";
+	print("meshes", meshUsage);
+	print("textures", textureTotals);
+	if (loading > 0)
+		std::cout << "  (" << loading << " textures still loading)\n";
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "assets.hpp"
+
+// GPU geometry (VAO + VBO + EBO). Shared by every mesh that draws the same source.
+struct GeometryResource
+{
+    GLuint VAO{0};                      // Vertex Array Object.
+    GLuint VBO{0};                      // Vertex Buffer Object.
+    GLuint EBO{0};                      // Element Buffer Object.
+    GLuint depthVAO{0};                 // Position-only VAO (location 0) over positionVBO and EBO, for depth passes.
+    GLuint positionVBO{0};              // Tightly packed vec3 positions.
+    GLenum index_type{GL_UNSIGNED_INT}; // GL_UNSIGNED_SHORT when all indices fit in 16 bits.
+    GLsizei index_count{0};             // Number of indices in the EBO.
+    size_t vertex_count{0};             // Number of vertices in the VBO.
+    size_t bytes{0};                    // GPU memory held by VBO + positionVBO + EBO.
+    AABB bounds;                        // Object-space bounds of the vertices.
+
+    GeometryResource() = default;
+    GeometryResource(const GeometryResource &) = delete;
+    GeometryResource &operator=(const GeometryResource &) = delete;
+    ~GeometryResource();
+};
+
+// A GL_TEXTURE_2D_ARRAY holding textures of one size, format and sampler state, one per layer.
+struct TextureArrayResource
+{
+    GLuint id{0}; // Texture object name.
+    int layers{0};
+
+    TextureArrayResource() = default;
+    TextureArrayResource(const TextureArrayResource &) = delete;
+    TextureArrayResource &operator=(const TextureArrayResource &) = delete;
+    ~TextureArrayResource();
+};
+
+// Texture units used by basic.frag: textureSampler (2D) and textureArray (2D array).
+constexpr GLuint kTextureUnit = 0;
+constexpr GLuint kTextureArrayUnit = 2;
+
+// A GL_TEXTURE_2D object, or a layer of a shared array once packed (see AssetManager::packTextures).
+// Shared by every mesh that samples the same image with the same parameters.
+struct TextureResource
+{
+    GLuint id{0};              // Texture object name (0 once packed into an array).
+    int width{0};              // Base level width in texels.
+    int height{0};             // Base level height in texels.
+    GLenum format{GL_RGBA8};   // Internal format of the storage.
+    GLsizei levels{1};         // Mip levels of the storage.
+    size_t bytes{0};           // Estimated GPU memory including the mip chain.
+    bool pending{false};       // Still loading: id is the shared placeholder's, not owned.
+    std::shared_ptr<TextureArrayResource> array; // Set once packed.
+    int layer{-1};             // Layer in array, -1 when not packed.
+
+    TextureResource() = default;
+    TextureResource(const TextureResource &) = delete;
+    TextureResource &operator=(const TextureResource &) = delete;
+    ~TextureResource();
+
+    // Name of the object to bind: the array for packed textures (shared by all its layers).
+    GLuint binding() const { return array ? array->id : id; }
+
+    // Binds to the unit basic.frag samples it from (kTextureArrayUnit for packed textures).
+    void bind() const { glBindTextureUnit(array ? kTextureArrayUnit : kTextureUnit, binding()); }
+};
+
+// Reference-counted handles; GL objects are released when the last holder goes away.
+using GeometryHandle = std::shared_ptr<GeometryResource>;
+using TextureHandle = std::shared_ptr<TextureResource>;
+
+// Sampler state that is part of a texture's identity.
+struct TextureParams
+{
+    GLenum wrap = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+};
+
+// Interns meshes by (path, shader) and textures by (path, parameters), so identical
+// models share one set of GPU buffers and one texture object.
+class TextureStreamer;
+
+class AssetManager
+{
+public:
+    // Process-wide registry; it only holds weak references, so it never keeps GL objects alive.
+    static AssetManager &instance();
+
+    // Returns the shared geometry of an OBJ file (through the binary mesh cache).
+    GeometryHandle loadMesh(const std::filesystem::path &path, GLuint program);
+
+    // Returns the shared texture for an image file. "NONE" gives a 1x1 yellow texture,
+    // an empty path a 1x1 white one. Images load in the background (see TextureStreamer); until
+    // then the texture shows the white placeholder, and it keeps it if the image cannot be read.
+    TextureHandle loadTexture(const std::string &path, const TextureParams &params = TextureParams());
+
+    // Uploads finished background texture loads (GL thread, once per frame); once every
+    // requested texture is in, packs them with packTextures().
+    void updateTextures();
+
+    // Moves loaded 2D textures that share size, format, mip count and sampler state into
+    // GL_TEXTURE_2D_ARRAYs (GPU-side copies), so meshes using any of them bind one object and
+    // pass their layer instead. Groups of a single texture stay 2D. Returns the textures packed.
+    size_t packTextures();
+
+    // Texture loader settings and progress.
+    TextureStreamer &textureStreamer() { return *streamer; }
+
+    // Uploads geometry that is not shared (procedural meshes). The attribute layout is taken from program.
+    GeometryHandle createGeometry(GLuint program, const Vertex *vertexData, size_t vertexCount,
+                                  const void *indexData, size_t indexCount, GLenum indexType);
+
+    // Prints how many requests were served from the registry and the GPU memory that saved.
+    void printReport() const;
+
+    // Stops the texture loader and drops the placeholder (call while the context is alive).
+    void clear();
+
+private:
+    AssetManager();
+    ~AssetManager();
+
+    // Counters for the memory report.
+    struct Usage
+    {
+        unsigned requests = 0;     // Calls to load*().
+        unsigned created = 0;      // GPU objects actually created.
+        size_t requestedBytes = 0; // Memory that would be used without sharing.
+        size_t createdBytes = 0;   // Memory actually allocated.
+    };
+
+    // Textures are sized only once loaded, so their memory is summed up when reporting.
+    struct TextureEntry
+    {
+        std::weak_ptr<TextureResource> texture;
+        unsigned requests = 0;
+        TextureParams params;
+    };
+
+    std::unordered_map<std::string, std::weak_ptr<GeometryResource>> meshes;
+    std::unordered_map<std::string, TextureEntry> textures;
+    Usage meshUsage;
+    Usage textureUsage;
+    std::unique_ptr<TextureStreamer> streamer;
+    TextureHandle placeholder; // White 1x1, shown by textures that are still loading.
+
+    TextureHandle createTexture(const std::string &path, const TextureParams &params);
+};
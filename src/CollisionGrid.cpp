@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+
+#include "CollisionGrid.hpp"
+
+void CollisionGrid::build(const std::vector<AABB> &input, float size)
+{
+	boxes.clear();
+	cellStart.assign(1, 0);
+	cellSize = size > 0.0f ? size : 1.0f;
+	invCellSize = 1.0f / cellSize;
+	cellsX = cellsZ = 0;
+	maxHalfExtent = glm::vec2(0.0f);
+	if (input.empty())
+		return;
+
+	// Grid covers the box centers; each box goes into exactly one cell, queries pad by the largest half-size.
+	glm::vec2 lo(INFINITY), hi(-INFINITY);
+	for (const AABB &box : input)
+	{
+		glm::vec3 c = box.center();
+		lo = glm::min(lo, glm::vec2(c.x, c.z));
+		hi = glm::max(hi, glm::vec2(c.x, c.z));
+		glm::vec3 e = box.extents();
+		maxHalfExtent = glm::max(maxHalfExtent, glm::vec2(e.x, e.z));
+	}
+	gridOrigin = lo;
+	cellsX = static_cast<int>((hi.x - lo.x) * invCellSize) + 1;
+	cellsZ = static_cast<int>((hi.y - lo.y) * invCellSize) + 1;
+
+	// Counting sort of the boxes by cell.
+	std::vector<uint32_t> cellOf(input.size());
+	cellStart.assign(cellCount() + 1, 0);
+	for (size_t i = 0; i < input.size(); ++i)
+	{
+		glm::vec3 c = input[i].center();
+		int x = std::min(static_cast<int>((c.x - gridOrigin.x) * invCellSize), cellsX - 1);
+		int z = std::min(static_cast<int>((c.z - gridOrigin.y) * invCellSize), cellsZ - 1);
+		cellOf[i] = static_cast<uint32_t>(z * cellsX + x);
+		++cellStart[cellOf[i] + 1];
+	}
+	for (size_t cell = 0; cell < cellCount(); ++cell)
+		cellStart[cell + 1] += cellStart[cell];
+
+	boxes.resize(input.size());
+	std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+	for (size_t i = 0; i < input.size(); ++i)
+		boxes[fill[cellOf[i]]++] = input[i];
+}
+
+template <typename Visit>
+bool CollisionGrid::visitCells(const AABB &region, Visit &&visit) const
+{
+	if (cellsX == 0)
+		return false;
+
+	// Cells whose boxes can reach the region (clamped in float, so far-away queries cannot overflow).
+	auto cellIndex = [&](float coordinate, float origin, int cells)
+	{
+		float cell = std::floor((coordinate - origin) * invCellSize);
+		return static_cast<int>(std::clamp(cell, -1.0f, static_cast<float>(cells)));
+	};
+	int x0 = std::max(cellIndex(region.min.x - maxHalfExtent.x, gridOrigin.x, cellsX), 0);
+	int x1 = std::min(cellIndex(region.max.x + maxHalfExtent.x, gridOrigin.x, cellsX), cellsX - 1);
+	int z0 = std::max(cellIndex(region.min.z - maxHalfExtent.y, gridOrigin.y, cellsZ), 0);
+	int z1 = std::min(cellIndex(region.max.z + maxHalfExtent.y, gridOrigin.y, cellsZ), cellsZ - 1);
+
+	for (int z = z0; z <= z1; ++z)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			size_t cell = static_cast<size_t>(z) * cellsX + x;
+			for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i)
+			{
+				if (visit(boxes[i]))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool CollisionGrid::overlaps(const AABB &box) const
+{
+	for (const AABB &dynamicBox : dynamicBoxes)
+	{
+		if (overlap(box, dynamicBox))
+			return true;
+	}
+	return visitCells(box, [&](const AABB &candidate)
+					  { return overlap(box, candidate); });
+}
+
+void CollisionGrid::gather(const AABB &region, std::vector<AABB> &out) const
+{
+	for (const AABB &dynamicBox : dynamicBoxes)
+	{
+		if (overlap(region, dynamicBox))
+			out.push_back(dynamicBox);
+	}
+	visitCells(region, [&](const AABB &candidate)
+			   {
+				   if (overlap(region, candidate))
+					   out.push_back(candidate);
+				   return false; });
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+
+// Broadphase for player collisions: static boxes (labyrinth walls) are bucketed once into a
+// uniform XZ grid, stored compressed (per-cell offsets into one index array). A few moving
+// boxes are kept in a separate list that is rebuilt every frame. A query only visits the
+// cells under the query box, so its cost does not depend on the size of the maze.
+//
+// Overlap tests are strict (touching boxes do not collide), like the original per-model scan.
+class CollisionGrid
+{
+public:
+    // Buckets the static boxes by their center; cellSize is usually the labyrinth cell size.
+    void build(const std::vector<AABB> &boxes, float cellSize);
+
+    // Moving colliders, replaced every frame.
+    void clearDynamic() { dynamicBoxes.clear(); }
+    void addDynamic(const AABB &box) { dynamicBoxes.push_back(box); }
+
+    // True if any static or dynamic box overlaps the query box.
+    bool overlaps(const AABB &box) const;
+
+    // Appends every static or dynamic box that overlaps the region.
+    void gather(const AABB &region, std::vector<AABB> &out) const;
+
+    size_t staticCount() const { return boxes.size(); }
+    size_t cellCount() const { return static_cast<size_t>(cellsX) * cellsZ; }
+
+private:
+    std::vector<AABB> boxes;         // Static boxes, ordered by cell.
+    std::vector<uint32_t> cellStart; // cellCount() + 1 offsets into boxes.
+    std::vector<AABB> dynamicBoxes;
+
+    glm::vec2 gridOrigin{0.0f}; // XZ of the corner of cell (0, 0).
+    float cellSize = 1.0f;
+    float invCellSize = 1.0f;
+    int cellsX = 0;
+    int cellsZ = 0;
+    glm::vec2 maxHalfExtent{0.0f}; // Largest XZ half-size of a static box (query padding).
+
+    static bool overlap(const AABB &a, const AABB &b)
+    {
+        return a.max.x > b.min.x && a.min.x < b.max.x &&
+               a.max.y > b.min.y && a.min.y < b.max.y &&
+               a.max.z > b.min.z && a.min.z < b.max.z;
+    }
+
+    // Calls visit(box) for candidate static boxes until it returns true; returns whether it did.
+    template <typename Visit>
+    bool visitCells(const AABB &region, Visit &&visit) const;
+};
@@ -0,0 +1,285 @@
+#include "FrameProfiler.hpp"
+
+#if PG2_PROFILER
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	FrameProfiler::Summary summarize(std::vector<double> &samples)
+	{
+		FrameProfiler::Summary summary;
+		if (samples.empty())
+			return summary;
+		std::sort(samples.begin(), samples.end());
+		double total = 0.0;
+		for (double sample : samples)
+			total += sample;
+		summary.samples = samples.size();
+		summary.min = samples.front();
+		summary.max = samples.back();
+		summary.avg = total / samples.size();
+		size_t rank = static_cast<size_t>(std::ceil(0.99 * samples.size()));
+		summary.p99 = samples[std::max<size_t>(rank, 1) - 1];
+		return summary;
+	}
+
+	double milliseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+const char *FrameProfiler::phaseName(Phase phase)
+{
+	static const char *const names[PHASE_COUNT] = {
+		"input", "uniforms", "shadow0", "shadow1", "shadow2", "shadow3",
+		"cull", "terrain", "sort", "opaque", "transparent", "swap"};
+	static_assert(kMaxShadowCascades == 4, "One shadow phase name per cascade");
+	return names[phase];
+}
+
+void FrameProfiler::beginFrame()
+{
+	if (!dumpsOpen)
+		openDumps();
+	slot = static_cast<int>(frameNumber % kQueryFrames);
+	// The slot last held the frame before the previous one; its queries are reused now.
+	collect(slot, false);
+
+	current = FrameRecord();
+	current.frame = frameNumber;
+	frameStart = Clock::now();
+}
+
+void FrameProfiler::endFrame()
+{
+	current.cpuFrameMs = milliseconds(Clock::now() - frameStart);
+	pending[slot] = current;
+	if (lastQuery[slot] < 0)
+		record(current); // Nothing to wait for.
+	++frameNumber;
+}
+
+void FrameProfiler::begin(Phase phase)
+{
+	GLuint &query = queries[slot][phase];
+	if (query == 0)
+		glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	phaseStart[phase] = Clock::now();
+}
+
+void FrameProfiler::end(Phase phase)
+{
+	current.cpuMs[phase] += milliseconds(Clock::now() - phaseStart[phase]);
+	current.ran[phase] = true;
+	glEndQuery(GL_TIME_ELAPSED);
+	lastQuery[slot] = phase;
+}
+
+void FrameProfiler::collect(int querySlot, bool wait)
+{
+	if (lastQuery[querySlot] < 0)
+		return;
+	FrameRecord &frame = pending[querySlot];
+
+	// Queries finish in order, so the last one ready means all of the frame's are.
+	GLuint available = GL_FALSE;
+	if (!wait)
+		glGetQueryObjectuiv(queries[querySlot][lastQuery[querySlot]], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (wait || available)
+	{
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			if (!frame.ran[phase])
+				continue;
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(queries[querySlot][phase], GL_QUERY_RESULT, &nanoseconds);
+			frame.gpuMs[phase] = static_cast<double>(nanoseconds) * 1e-6;
+		}
+		frame.gpuValid = true;
+	}
+	lastQuery[querySlot] = -1;
+	record(frame);
+}
+
+void FrameProfiler::record(const FrameRecord &frame)
+{
+	history.push_back(frame);
+	while (history.size() > std::max<size_t>(settings.window, 1))
+		history.pop_front();
+
+	double gpuFrameMs = 0.0;
+	for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		gpuFrameMs += frame.gpuMs[phase];
+
+	if (csv.is_open())
+	{
+		csv << frame.frame << ',' << frame.cpuFrameMs << ',';
+		if (frame.gpuValid)
+			csv << gpuFrameMs;
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			csv << ',';
+			if (frame.ran[phase])
+				csv << frame.cpuMs[phase];
+			csv << ',';
+			if (frame.ran[phase] && frame.gpuValid)
+				csv << frame.gpuMs[phase];
+		}
+		csv << '\n';
+	}
+
+	if (json.is_open())
+	{
+		json << (firstJsonRecord ? "  {" : ",\n  {");
+		firstJsonRecord = false;
+		json << "\"frame\": " << frame.frame << ", \"cpu_ms\": " << frame.cpuFrameMs << ", \"gpu_ms\": ";
+		if (frame.gpuValid)
+			json << gpuFrameMs;
+		else
+			json << "null";
+		json << ", \"phases\": {";
+		bool firstPhase = true;
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			if (!frame.ran[phase])
+				continue;
+			json << (firstPhase ? "" : ", ") << '"' << phaseName(static_cast<Phase>(phase)) << "\": {\"cpu_ms\": " << frame.cpuMs[phase] << ", \"gpu_ms\": ";
+			if (frame.gpuValid)
+				json << frame.gpuMs[phase];
+			else
+				json << "null";
+			json << '}';
+			firstPhase = false;
+		}
+		json << "}}";
+	}
+}
+
+void FrameProfiler::openDumps()
+{
+	dumpsOpen = true;
+	if (!settings.csvPath.empty())
+	{
+		csv.open(settings.csvPath);
+		if (!csv)
+			std::cerr << "Warning: Cannot write profile " << settings.csvPath << "\n";
+		else
+		{
+			csv << "frame,cpu_frame_ms,gpu_frame_ms";
+			for (int phase = 0; phase < PHASE_COUNT; ++phase)
+			{
+				const char *name = phaseName(static_cast<Phase>(phase));
+				csv << ',' << name << "_cpu_ms," << name << "_gpu_ms";
+			}
+			csv << '\n';
+		}
+	}
+	if (!settings.jsonPath.empty())
+	{
+		json.open(settings.jsonPath);
+		if (!json)
+			std::cerr << "Warning: Cannot write profile " << settings.jsonPath << "\n";
+		else
+			json << "[\n";
+	}
+}
+
+FrameProfiler::Report FrameProfiler::report() const
+{
+	Report result;
+	std::vector<double> samples;
+	samples.reserve(history.size());
+	for (int phase = 0; phase < PHASE_COUNT; ++phase)
+	{
+		samples.clear();
+		for (const FrameRecord &frame : history)
+			if (frame.ran[phase])
+				samples.push_back(frame.cpuMs[phase]);
+		result.cpu[phase] = summarize(samples);
+
+		samples.clear();
+		for (const FrameRecord &frame : history)
+			if (frame.ran[phase] && frame.gpuValid)
+				samples.push_back(frame.gpuMs[phase]);
+		result.gpu[phase] = summarize(samples);
+	}
+
+	samples.clear();
+	for (const FrameRecord &frame : history)
+		samples.push_back(frame.cpuFrameMs);
+	result.cpuFrame = summarize(samples);
+
+	samples.clear();
+	for (const FrameRecord &frame : history)
+	{
+		if (!frame.gpuValid)
+			continue;
+		double total = 0.0;
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+			total += frame.gpuMs[phase];
+		samples.push_back(total);
+	}
+	result.gpuFrame = summarize(samples);
+	return result;
+}
+
+void FrameProfiler::print(std::ostream &out) const
+{
+	Report result = report();
+	auto row = [&out](const char *name, const char *clock, const Summary &summary) {
+		out << std::setw(12) << name << std::setw(5) << clock << std::setw(9) << summary.min << std::setw(9) << summary.avg
+			<< std::setw(9) << summary.p99 << std::setw(9) << summary.max << std::setw(8) << summary.samples << "\n";
+	};
+
+	std::ios_base::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << "Frame profile over the last " << history.size() << " frames (ms)\n"
+		<< std::setw(12) << "phase" << std::setw(5) << "" << std::setw(9) << "min" << std::setw(9) << "avg"
+		<< std::setw(9) << "p99" << std::setw(9) << "max" << std::setw(8) << "frames" << "\n"
+		<< std::fixed << std::setprecision(3);
+	for (int phase = 0; phase < PHASE_COUNT; ++phase)
+	{
+		if (result.cpu[phase].samples == 0)
+			continue;
+		row(phaseName(static_cast<Phase>(phase)), "cpu", result.cpu[phase]);
+		row("", "gpu", result.gpu[phase]);
+	}
+	row("frame", "cpu", result.cpuFrame);
+	row("", "gpu", result.gpuFrame);
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void FrameProfiler::finish()
+{
+	// Oldest frame first, so the dumps stay in order.
+	for (int i = 0; i < kQueryFrames; ++i)
+		collect(static_cast<int>((frameNumber + i) % kQueryFrames), true);
+	if (json.is_open())
+		json << "\n]\n";
+	csv.close();
+	json.close();
+}
+
+void FrameProfiler::clear()
+{
+	for (int frame = 0; frame < kQueryFrames; ++frame)
+	{
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			if (queries[frame][phase] != 0)
+				glDeleteQueries(1, &queries[frame][phase]);
+			queries[frame][phase] = 0;
+		}
+		lastQuery[frame] = -1;
+	}
+}
+
+#endif
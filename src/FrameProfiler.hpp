@@ -0,0 +1,162 @@
+#pragma once
+
+// Compile-time switch (CMake option PG2_ENABLE_PROFILER). With 0 only the forward declaration
+// below remains and every PG2_PROFILE_* macro expands to nothing.
+#ifndef PG2_PROFILER
+#define PG2_PROFILER 1
+#endif
+
+class FrameProfiler;
+
+#if PG2_PROFILER
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "UniformBlocks.hpp"
+
+// CPU and GPU time of each phase of a frame. A phase is timed on the CPU with std::chrono and on
+// the GPU with a GL_TIME_ELAPSED query; the queries are double-buffered, so a frame's GPU times
+// are read back when its query slot comes round again two frames later, without waiting for the
+// GPU (a frame whose results are not ready by then has no GPU times). Completed frames feed a
+// sliding window of min / avg / p99 / max and, if paths are set, per-frame CSV and JSON dumps.
+//
+// Per frame: beginFrame(), then begin(phase) / end(phase) around each phase (phases must not
+// overlap: GL_TIME_ELAPSED queries cannot nest), then endFrame(). Phases that do not run in a
+// frame are left out of its statistics.
+class FrameProfiler
+{
+public:
+    enum Phase
+    {
+        INPUT_PHASE,                                       // Input, simulation sample, streamed textures.
+        UNIFORMS_PHASE,                                    // Light clusters and frame uniform upload.
+        SHADOW_PHASE,                                      // First of kMaxShadowCascades cascade passes.
+        CULL_PHASE = SHADOW_PHASE + kMaxShadowCascades,    // Model animation, BVH refit and culling.
+        TERRAIN_PHASE,                                     // Terrain streaming and drawing.
+        SORT_PHASE,                                        // RenderQueue key sort, batching, matrix upload.
+        OPAQUE_PHASE,                                      // Depth pre-pass and opaque draws.
+        TRANSPARENT_PHASE,                                 // Transparent draws and OIT composite.
+        SWAP_PHASE,                                        // Event polling and buffer swap.
+        PHASE_COUNT
+    };
+
+    struct Settings
+    {
+        size_t window = 300;  // Frames in the sliding statistics window.
+        std::string csvPath;  // Per-frame CSV dump, none if empty.
+        std::string jsonPath; // Per-frame JSON dump, none if empty.
+    };
+
+    // Milliseconds over the frames of the window that ran the phase (all zero if none did).
+    struct Summary
+    {
+        double min = 0.0, avg = 0.0, p99 = 0.0, max = 0.0;
+        size_t samples = 0;
+    };
+
+    struct Report
+    {
+        Summary cpu[PHASE_COUNT];
+        Summary gpu[PHASE_COUNT];
+        Summary cpuFrame; // beginFrame() to endFrame().
+        Summary gpuFrame; // Sum of the GPU phases.
+    };
+
+    // RAII phase.
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler &profiler, Phase phase) : profiler(profiler), phase(phase) { profiler.begin(phase); }
+        ~Scope() { profiler.end(phase); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        FrameProfiler &profiler;
+        Phase phase;
+    };
+
+    Settings settings;
+
+    FrameProfiler() = default;
+    FrameProfiler(const FrameProfiler &) = delete;
+    FrameProfiler &operator=(const FrameProfiler &) = delete;
+    ~FrameProfiler() { clear(); }
+
+    void beginFrame();
+    void endFrame();
+    void begin(Phase phase);
+    void end(Phase phase);
+
+    // Statistics of the current window.
+    Report report() const;
+    void print(std::ostream &out) const;
+
+    static const char *phaseName(Phase phase);
+
+    // Waits for the outstanding queries, records their frames and closes the dumps.
+    void finish();
+
+    // Releases the queries (call while the GL context is alive).
+    void clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameRecord
+    {
+        uint64_t frame = 0;
+        double cpuFrameMs = 0.0;
+        double cpuMs[PHASE_COUNT] = {};
+        double gpuMs[PHASE_COUNT] = {};
+        bool ran[PHASE_COUNT] = {};
+        bool gpuValid = false;
+    };
+
+    static constexpr int kQueryFrames = 2;
+    GLuint queries[kQueryFrames][PHASE_COUNT] = {};
+    int lastQuery[kQueryFrames] = {-1, -1}; // Phase whose query ended last; -1 if none is pending.
+    FrameRecord pending[kQueryFrames];      // Frames waiting for their GPU times.
+
+    FrameRecord current;
+    uint64_t frameNumber = 0;
+    int slot = 0;
+    Clock::time_point frameStart;
+    Clock::time_point phaseStart[PHASE_COUNT];
+
+    std::deque<FrameRecord> history;
+
+    std::ofstream csv, json;
+    bool dumpsOpen = false;
+    bool firstJsonRecord = true;
+
+    void collect(int querySlot, bool wait);
+    void record(const FrameRecord &frame);
+    void openDumps();
+};
+
+#define PG2_PROFILE_CONCAT_(a, b) a##b
+#define PG2_PROFILE_CONCAT(a, b) PG2_PROFILE_CONCAT_(a, b)
+// profiler is a FrameProfiler object; the _OPTIONAL variants take a pointer that may be null.
+#define PG2_PROFILE_SCOPE(profiler, phase) FrameProfiler::Scope PG2_PROFILE_CONCAT(profileScope, __LINE__)(profiler, phase)
+#define PG2_PROFILE_BEGIN(profiler, phase) (profiler).begin(phase)
+#define PG2_PROFILE_END(profiler, phase) (profiler).end(phase)
+#define PG2_PROFILE_BEGIN_OPTIONAL(profiler, phase) do { if (profiler) (profiler)->begin(phase); } while (0)
+#define PG2_PROFILE_END_OPTIONAL(profiler, phase) do { if (profiler) (profiler)->end(phase); } while (0)
+
+#else
+
+#define PG2_PROFILE_SCOPE(profiler, phase) ((void)0)
+#define PG2_PROFILE_BEGIN(profiler, phase) ((void)0)
+#define PG2_PROFILE_END(profiler, phase) ((void)0)
+#define PG2_PROFILE_BEGIN_OPTIONAL(profiler, phase) ((void)0)
+#define PG2_PROFILE_END_OPTIONAL(profiler, phase) ((void)0)
+
+#endif
@@ -0,0 +1,99 @@
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PG2_SSE 1
+#endif
+
+#include "HeightField.hpp"
+
+HeightField::HeightField(const std::vector<float> &input, int columns, int rowsIn, float heightScale)
+	: cols(std::max(columns, 1)), rowCount(std::max(rowsIn, 1))
+{
+	stride = static_cast<size_t>(cols) + 1;
+	half = glm::vec2(cols * 0.5f, rowCount * 0.5f);
+	maxCoord = glm::vec2(static_cast<float>(cols - 1), static_cast<float>(rowCount - 1));
+
+	size_t padded = stride * (rowCount + 1);
+	heights.assign(padded, 0.0f);
+	for (int z = 0; z < rowCount; ++z)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			size_t source = static_cast<size_t>(z) * columns + x;
+			heights[index(x, z)] = source < input.size() ? input[source] * heightScale : 0.0f;
+		}
+	}
+
+	normalX.assign(padded, 0.0f);
+	normalY.assign(padded, 1.0f);
+	normalZ.assign(padded, 0.0f);
+	computeNormals();
+
+	// Duplicate the last column and row into the padding.
+	for (std::vector<float> *grid : {&heights, &normalX, &normalY, &normalZ})
+	{
+		std::vector<float> &g = *grid;
+		for (int z = 0; z < rowCount; ++z)
+			g[index(cols, z)] = g[index(cols - 1, z)];
+		std::copy(g.begin() + index(0, rowCount - 1), g.begin() + index(0, rowCount), g.begin() + index(0, rowCount));
+	}
+}
+
+void HeightField::computeNormals()
+{
+	// Central differences of the height (one-sided at the borders); with one world unit per
+	// sample the normal of y = h(x, z) is normalize(-dh/dx, 1, -dh/dz).
+	auto store = [&](size_t i, float gx, float gz)
+	{
+		float inv = 1.0f / std::sqrt(gx * gx + gz * gz + 1.0f);
+		normalX[i] = -gx * inv;
+		normalY[i] = inv;
+		normalZ[i] = -gz * inv;
+	};
+
+	for (int z = 0; z < rowCount; ++z)
+	{
+		int zUp = std::max(z - 1, 0);
+		int zDown = std::min(z + 1, rowCount - 1);
+		float zScale = zDown > zUp ? 1.0f / (zDown - zUp) : 0.0f;
+		const float *row = heights.data() + index(0, z);
+		const float *up = heights.data() + index(0, zUp);
+		const float *down = heights.data() + index(0, zDown);
+		size_t base = index(0, z);
+
+		auto scalar = [&](int x)
+		{
+			int xLeft = std::max(x - 1, 0);
+			int xRight = std::min(x + 1, cols - 1);
+			float xScale = xRight > xLeft ? 1.0f / (xRight - xLeft) : 0.0f;
+			store(base + x, (row[xRight] - row[xLeft]) * xScale, (down[x] - up[x]) * zScale);
+		};
+
+		int x = 0;
+		if (cols > 2)
+		{
+			scalar(0);
+			x = 1;
+#ifdef PG2_SSE
+			// Interior columns, four at a time, with the same operations as the scalar path.
+			const __m128 halfX = _mm_set1_ps(0.5f);
+			const __m128 scaleZ = _mm_set1_ps(zScale);
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 sign = _mm_set1_ps(-0.0f);
+			for (; x + 4 <= cols - 1; x += 4)
+			{
+				__m128 gx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + x + 1), _mm_loadu_ps(row + x - 1)), halfX);
+				__m128 gz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(down + x), _mm_loadu_ps(up + x)), scaleZ);
+				__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gz, gz)), one);
+				__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+				_mm_storeu_ps(normalX.data() + base + x, _mm_mul_ps(_mm_xor_ps(gx, sign), inv));
+				_mm_storeu_ps(normalY.data() + base + x, inv);
+				_mm_storeu_ps(normalZ.data() + base + x, _mm_mul_ps(_mm_xor_ps(gz, sign), inv));
+			}
+#endif
+		}
+		for (; x < cols; ++x)
+			scalar(x);
+	}
+}
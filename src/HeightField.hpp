@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Regular grid of terrain heights with precomputed smooth normals, one sample per world unit.
+// Sample (x, z) sits at local position (x - columns/2, z - rows/2), like the heightmap mesh vertices.
+//
+// The grids are padded with a duplicated last column and row, so a bilinear query only clamps
+// its coordinates and never tests the cell index. The default field is a single flat sample:
+// queries on it return height 0 and the up normal, which lets models without terrain share the
+// same branch-free code path.
+class HeightField
+{
+public:
+    HeightField() : HeightField(std::vector<float>(1, 0.0f), 1, 1, 1.0f) {}
+
+    // heights are row-major (columns x rows) and normalized to [0, 1]; they are stored scaled.
+    HeightField(const std::vector<float> &heights, int columns, int rows, float heightScale);
+
+    int columns() const { return cols; }
+    int rows() const { return rowCount; }
+
+    float sampleHeight(int x, int z) const { return heights[index(x, z)]; }
+    glm::vec3 sampleNormal(int x, int z) const
+    {
+        size_t i = index(x, z);
+        return glm::vec3(normalX[i], normalY[i], normalZ[i]);
+    }
+
+    // Bilinear height at a local position; positions outside the grid take the border value.
+    float heightAt(float localX, float localZ) const
+    {
+        float fx, fz;
+        size_t i = cellOf(localX, localZ, fx, fz);
+        return bilinear(heights.data() + i, fx, fz);
+    }
+
+    // Bilinear blend of the four surrounding vertex normals, renormalized.
+    glm::vec3 normalAt(float localX, float localZ) const
+    {
+        float fx, fz;
+        size_t i = cellOf(localX, localZ, fx, fz);
+        return glm::normalize(glm::vec3(bilinear(normalX.data() + i, fx, fz),
+                                        bilinear(normalY.data() + i, fx, fz),
+                                        bilinear(normalZ.data() + i, fx, fz)));
+    }
+
+private:
+    int cols = 1;
+    int rowCount = 1;
+    size_t stride = 2; // cols + 1 (padding column).
+    glm::vec2 half{0.0f}; // Local position of sample (0, 0), negated.
+    glm::vec2 maxCoord{0.0f};
+
+    // (cols + 1) x (rows + 1), padded.
+    std::vector<float> heights;
+    std::vector<float> normalX, normalY, normalZ;
+
+    size_t index(int x, int z) const { return static_cast<size_t>(z) * stride + x; }
+
+    // Index of the cell's first corner and the position inside the cell (clamped, no branches).
+    size_t cellOf(float localX, float localZ, float &fx, float &fz) const
+    {
+        float gx = std::clamp(localX + half.x, 0.0f, maxCoord.x);
+        float gz = std::clamp(localZ + half.y, 0.0f, maxCoord.y);
+        int x = static_cast<int>(gx);
+        int z = static_cast<int>(gz);
+        fx = gx - x;
+        fz = gz - z;
+        return index(x, z);
+    }
+
+    float bilinear(const float *corner, float fx, float fz) const
+    {
+        float top = corner[0] + (corner[1] - corner[0]) * fx;
+        float bottom = corner[stride] + (corner[stride + 1] - corner[stride]) * fx;
+        return top + (bottom - top) * fz;
+    }
+
+    void computeNormals();
+};
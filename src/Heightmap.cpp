@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <opencv2/opencv.hpp>
+
+#include "Heightmap.hpp"
+#include "MappedFile.hpp"
+
+// Headerless little-endian 16-bit samples; the map must be square.
+static cv::Mat readRawHeightmap(const std::string &path)
+{
+	MappedFile file(path);
+	if (!file.isOpen())
+		return cv::Mat();
+
+	size_t count = file.size() / 2;
+	int side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(count))));
+	if (count == 0 || file.size() % 2 != 0 || static_cast<size_t>(side) * side != count)
+	{
+		std::cerr << "Error: RAW heightmap is not a square of 16-bit samples (" << file.size() << " bytes): " << path << "\n";
+		throw std::runtime_error("Heightmap loading failed");
+	}
+
+	cv::Mat image(side, side, CV_16U);
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(file.data());
+	uint16_t *out = image.ptr<uint16_t>(0);
+	for (size_t i = 0; i < count; ++i)
+		out[i] = static_cast<uint16_t>(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+	return image;
+}
+
+QuantizedHeightmap loadHeightmap(const std::string &path, int width, int depth)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+				   { return static_cast<char>(std::tolower(c)); });
+
+	// IMREAD_ANYDEPTH keeps 16-bit images 16-bit (and still converts color to gray).
+	cv::Mat image = extension == ".raw" || extension == ".r16" ? readRawHeightmap(path)
+															   : cv::imread(path, cv::IMREAD_ANYDEPTH);
+	if (image.empty())
+	{
+		std::cerr << "Error: Failed to load heightmap: " << path << "\n";
+		throw std::runtime_error("Heightmap loading failed");
+	}
+	if (image.depth() != CV_16U)
+		image.convertTo(image, CV_16U, image.depth() == CV_8U ? 257.0 : 65535.0); // 8-bit or float [0, 1].
+	if (width > 1 && depth > 1 && (image.cols != width || image.rows != depth))
+		cv::resize(image, image, cv::Size(width, depth));
+	if (!image.isContinuous())
+		image = image.clone();
+
+	QuantizedHeightmap map;
+	map.columns = image.cols;
+	map.rows = image.rows;
+	const uint16_t *source = image.ptr<uint16_t>(0);
+	const size_t count = static_cast<size_t>(map.columns) * map.rows;
+	auto [lo, hi] = std::minmax_element(source, source + count);
+
+	// Stretch min..max over 0..65535; the offset and range map the samples back.
+	const uint16_t minimum = *lo, maximum = *hi;
+	map.offset = minimum / 65535.0f;
+	map.range = (maximum - minimum) / 65535.0f;
+	map.samples.resize(count);
+	const double stretch = maximum > minimum ? 65535.0 / (maximum - minimum) : 0.0;
+	for (size_t i = 0; i < count; ++i)
+		map.samples[i] = static_cast<uint16_t>(std::lround((source[i] - minimum) * stretch));
+	return map;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Heightmap samples quantized to the full 16-bit range of the source's own min..max, so flat
+// maps with a small relief keep all 65536 levels. Normalized height (0 = black, 1 = white) of a
+// sample q is offset + q / 65535 * range.
+struct QuantizedHeightmap
+{
+    std::vector<uint16_t> samples; // Row-major, columns x rows.
+    int columns = 0;
+    int rows = 0;
+    float offset = 0.0f;
+    float range = 0.0f;
+
+    bool empty() const { return samples.empty(); }
+    size_t bytes() const { return samples.size() * sizeof(uint16_t); }
+    float normalized(size_t i) const { return offset + samples[i] * (range / 65535.0f); }
+};
+
+// Loads 8- or 16-bit grayscale images (PNG, TIFF, ...) at full precision, or headerless
+// little-endian 16-bit square .raw / .r16 files; 8-bit sources are widened to 16 bits.
+// The map is resized to width x depth samples if both are given.
+QuantizedHeightmap loadHeightmap(const std::string &path, int width = 0, int depth = 0);
@@ -0,0 +1,91 @@
+#include <random>
+#include <stack>
+#include <utility>
+
+#include "Labyrinth.hpp"
+
+// Carves a perfect maze (randomized depth-first search) into a size x size grid of walls.
+// Cells with odd coordinates are rooms; the entrance and exit are opened in the outer wall.
+static std::vector<int> generateLabyrinth(int size)
+{
+	std::vector<int> grid(static_cast<size_t>(size) * size, 1);
+	std::mt19937 rng(12345u); // Fixed seed: the same size always gives the same labyrinth
+	int rooms = (size - 1) / 2;
+	if (rooms < 1)
+		return grid;
+
+	std::stack<std::pair<int, int>> stack;
+	grid[1 * size + 1] = 0;
+	stack.push({1, 1});
+	const int dx[4] = {2, -2, 0, 0};
+	const int dz[4] = {0, 0, 2, -2};
+	while (!stack.empty())
+	{
+		auto [x, z] = stack.top();
+		int candidates[4];
+		int count = 0;
+		for (int d = 0; d < 4; ++d)
+		{
+			int nx = x + dx[d], nz = z + dz[d];
+			if (nx > 0 && nz > 0 && nx <= 2 * rooms - 1 && nz <= 2 * rooms - 1 && grid[nz * size + nx] == 1)
+				candidates[count++] = d;
+		}
+		if (count == 0)
+		{
+			stack.pop();
+			continue;
+		}
+		int d = candidates[rng() % count];
+		grid[(z + dz[d] / 2) * size + (x + dx[d] / 2)] = 0;
+		grid[(z + dz[d]) * size + (x + dx[d])] = 0;
+		stack.push({x + dx[d], z + dz[d]});
+	}
+
+	// Entrance at the top, exit at the bottom.
+	grid[0 * size + 1] = 0;
+	for (int z = 2 * rooms; z < size; ++z)
+		grid[z * size + (2 * rooms - 1)] = 0;
+	return grid;
+}
+
+std::vector<int> makeLabyrinth(int size)
+{
+	if (size != 10)
+		return generateLabyrinth(size);
+
+	return {
+		1, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		1, 0, 0, 0, 1, 0, 0, 0, 0, 1,
+		1, 0, 1, 0, 1, 0, 1, 1, 0, 1,
+		1, 0, 1, 0, 0, 0, 0, 1, 0, 1,
+		1, 0, 1, 1, 1, 1, 0, 1, 0, 1,
+		1, 0, 0, 0, 0, 1, 0, 0, 0, 1,
+		1, 1, 1, 1, 0, 1, 1, 1, 0, 1,
+		1, 0, 0, 1, 0, 0, 0, 1, 0, 1,
+		1, 0, 0, 0, 0, 1, 0, 0, 0, 1,
+		1, 1, 1, 1, 1, 1, 1, 0, 1, 1};
+}
+
+glm::vec3 labyrinthCellOrigin(int x, int z, int size, float cubeSize)
+{
+	float halfExtent = size * cubeSize * 0.5f;
+	return glm::vec3(x * cubeSize - halfExtent, 0.0f, z * cubeSize - halfExtent);
+}
+
+std::vector<AABB> labyrinthWallBoxes(const std::vector<int> &grid, int size, float cubeSize)
+{
+	std::vector<AABB> boxes;
+	glm::vec3 half(0.5f * cubeSize);
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			if (grid[z * size + x] == 1)
+			{
+				glm::vec3 origin = labyrinthCellOrigin(x, z, size, cubeSize);
+				boxes.push_back(AABB{origin - half, origin + half});
+			}
+		}
+	}
+	return boxes;
+}
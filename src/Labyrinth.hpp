@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+
+// Labyrinth layout shared by the application, the tools and the benchmarks.
+// Grids are size x size, row-major (index z * size + x), 1 = wall cube, 0 = free.
+
+// The hand-made layout for size 10, a generated (seeded, so reproducible) maze for any other size.
+std::vector<int> makeLabyrinth(int size);
+
+// Center of cell (x, z); the labyrinth is centered around the origin at ground level.
+glm::vec3 labyrinthCellOrigin(int x, int z, int size, float cubeSize);
+
+// World-space boxes of all wall cubes (unit cubes scaled by cubeSize).
+std::vector<AABB> labyrinthWallBoxes(const std::vector<int> &grid, int size, float cubeSize);
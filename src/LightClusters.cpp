@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PG2_SSE 1
+#endif
+
+#include "LightClusters.hpp"
+
+float lightRange(const ClusterLight &light)
+{
+	float peak = std::max({light.ambient.x, light.ambient.y, light.ambient.z,
+						   light.diffuse.x, light.diffuse.y, light.diffuse.z,
+						   light.specular.x, light.specular.y, light.specular.z});
+	// Solve constant + linear d + quadratic d^2 = peak / cutoff.
+	float target = peak / kLightCutoff - light.constant;
+	if (target <= 0.0f)
+		return 1e-4f; // Never brighter than the cutoff.
+	if (light.quadratic > 0.0f)
+		return (-light.linear + std::sqrt(light.linear * light.linear + 4.0f * light.quadratic * target)) / (2.0f * light.quadratic);
+	if (light.linear > 0.0f)
+		return target / light.linear;
+	return 0.0f;
+}
+
+void LightClusters::setProjection(const glm::mat4 &projection, int width, int height)
+{
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (projection == lastProjection && width == viewportWidth && height == viewportHeight)
+		return;
+	lastProjection = projection;
+	viewportWidth = width;
+	viewportHeight = height;
+
+	// glm::perspective: [2][2] = -(f + n) / (f - n), [3][2] = -2fn / (f - n).
+	tanHalfX = 1.0f / projection[0][0];
+	tanHalfY = 1.0f / projection[1][1];
+	nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+	farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	if (!std::isfinite(farPlane) || farPlane <= nearDepth)
+		farPlane = 1e30f; // Infinite far plane.
+	float clusterFar = std::max(std::min(settings.farDepth, farPlane), nearDepth * 2.0f);
+
+	const int slices = settings.slices;
+	logScale = static_cast<float>(slices) / std::log(clusterFar / nearDepth);
+	logBias = -std::log(nearDepth) * logScale;
+	sliceNear.resize(slices);
+	sliceFar.resize(slices);
+	for (int s = 0; s < slices; ++s)
+	{
+		sliceNear[s] = nearDepth * std::pow(clusterFar / nearDepth, static_cast<float>(s) / slices);
+		sliceFar[s] = s + 1 == slices ? farPlane : nearDepth * std::pow(clusterFar / nearDepth, static_cast<float>(s + 1) / slices);
+	}
+
+	// Tiles are whole pixels, so the last column and row may reach past the screen edge.
+	tilePixels = glm::vec2(std::ceil(static_cast<float>(width) / settings.tilesX),
+						   std::ceil(static_cast<float>(height) / settings.tilesY));
+	tileNdcX.resize(settings.tilesX + 1);
+	tileNdcY.resize(settings.tilesY + 1);
+	for (int x = 0; x <= settings.tilesX; ++x)
+		tileNdcX[x] = 2.0f * x * tilePixels.x / width - 1.0f;
+	for (int y = 0; y <= settings.tilesY; ++y)
+		tileNdcY[y] = 2.0f * y * tilePixels.y / height - 1.0f;
+
+	// A tile's side planes pass through the eye, so its extent at depth z is ndc * z * tanHalf.
+	// Three floats of padding let the x loop of addLight() load four tiles past any column.
+	auto extents = [&](const std::vector<float> &edges, int tiles, float tanHalf, std::vector<float> &lo, std::vector<float> &hi)
+	{
+		lo.assign(static_cast<size_t>(slices) * tiles + 3, 0.0f);
+		hi.assign(lo.size(), 0.0f);
+		for (int s = 0; s < slices; ++s)
+		{
+			for (int t = 0; t < tiles; ++t)
+			{
+				lo[s * tiles + t] = std::min(edges[t] * sliceNear[s], edges[t] * sliceFar[s]) * tanHalf;
+				hi[s * tiles + t] = std::max(edges[t + 1] * sliceNear[s], edges[t + 1] * sliceFar[s]) * tanHalf;
+			}
+		}
+	};
+	extents(tileNdcX, settings.tilesX, tanHalfX, minX, maxX);
+	extents(tileNdcY, settings.tilesY, tanHalfY, minY, maxY);
+}
+
+int LightClusters::sliceOf(float depth) const
+{
+	if (depth <= nearDepth)
+		return 0;
+	return std::clamp(static_cast<int>(std::floor(std::log(depth) * logScale + logBias)), 0, settings.slices - 1);
+}
+
+int LightClusters::tileOf(float ndc, int tiles, int pixels, float tileSize)
+{
+	float pixel = (ndc + 1.0f) * 0.5f * pixels;
+	return static_cast<int>(std::clamp(std::floor(pixel / tileSize), 0.0f, static_cast<float>(tiles - 1)));
+}
+
+void LightClusters::addLight(uint32_t index, const ClusterLight &light, const glm::mat4 &view)
+{
+	const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+	const float depth = -center.z;
+	const bool bounded = light.range > 0.0f;
+	const float radius = light.range;
+	const float radiusSq = radius * radius;
+
+	int s0 = 0, s1 = settings.slices - 1;
+	int x0 = 0, x1 = settings.tilesX - 1;
+	int y0 = 0, y1 = settings.tilesY - 1;
+	if (bounded)
+	{
+		if (depth + radius < nearDepth || depth - radius > farPlane)
+			return;
+		float zlo = std::max(depth - radius, nearDepth);
+		float zhi = std::min(depth + radius, farPlane);
+		s0 = sliceOf(zlo);
+		s1 = sliceOf(zhi);
+
+		// The sphere's x (y) range divided by depth is extremal at the nearest or farthest depth it covers.
+#ifdef PG2_SSE
+		// Lanes: min x, min y, max x, max y.
+		const __m128 extent = _mm_setr_ps(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+		const __m128 atNear = _mm_div_ps(extent, _mm_set1_ps(zlo));
+		const __m128 atFar = _mm_div_ps(extent, _mm_set1_ps(zhi));
+		__m128 ndc = _mm_shuffle_ps(_mm_min_ps(atNear, atFar), _mm_max_ps(atNear, atFar), _MM_SHUFFLE(3, 2, 1, 0));
+		ndc = _mm_div_ps(ndc, _mm_setr_ps(tanHalfX, tanHalfY, tanHalfX, tanHalfY));
+
+		// Off screen if a minimum is past the last tile edge or a maximum before -1 (negated, past 1).
+		const __m128 sign = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+		const __m128 limit = _mm_setr_ps(tileNdcX.back(), tileNdcY.back(), 1.0f, 1.0f);
+		if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_mul_ps(ndc, sign), limit)))
+			return;
+
+		// tileOf() on all four: floor(pixel / tile size) clamped to the grid.
+		const __m128 pixels = _mm_setr_ps(static_cast<float>(viewportWidth), static_cast<float>(viewportHeight),
+										  static_cast<float>(viewportWidth), static_cast<float>(viewportHeight));
+		const __m128 tileSizes = _mm_setr_ps(tilePixels.x, tilePixels.y, tilePixels.x, tilePixels.y);
+		const __m128 lastTile = _mm_setr_ps(static_cast<float>(settings.tilesX - 1), static_cast<float>(settings.tilesY - 1),
+											static_cast<float>(settings.tilesX - 1), static_cast<float>(settings.tilesY - 1));
+		__m128 tile = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(ndc, _mm_set1_ps(1.0f)), _mm_set1_ps(0.5f)), pixels), tileSizes);
+		tile = _mm_min_ps(_mm_max_ps(tile, _mm_setzero_ps()), lastTile);
+		alignas(16) int tiles[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(tiles), _mm_cvttps_epi32(tile)); // Truncation is floor here: tile >= 0.
+		x0 = tiles[0];
+		y0 = tiles[1];
+		x1 = tiles[2];
+		y1 = tiles[3];
+#else
+		float ndcMinX = std::min((center.x - radius) / zlo, (center.x - radius) / zhi) / tanHalfX;
+		float ndcMaxX = std::max((center.x + radius) / zlo, (center.x + radius) / zhi) / tanHalfX;
+		float ndcMinY = std::min((center.y - radius) / zlo, (center.y - radius) / zhi) / tanHalfY;
+		float ndcMaxY = std::max((center.y + radius) / zlo, (center.y + radius) / zhi) / tanHalfY;
+		if (ndcMaxX < -1.0f || ndcMinX > tileNdcX.back() || ndcMaxY < -1.0f || ndcMinY > tileNdcY.back())
+			return;
+		x0 = tileOf(ndcMinX, settings.tilesX, viewportWidth, tilePixels.x);
+		x1 = tileOf(ndcMaxX, settings.tilesX, viewportWidth, tilePixels.x);
+		y0 = tileOf(ndcMinY, settings.tilesY, viewportHeight, tilePixels.y);
+		y1 = tileOf(ndcMaxY, settings.tilesY, viewportHeight, tilePixels.y);
+#endif
+	}
+
+	// Spot cone against the cluster's bounding sphere (conservative).
+	const bool spot = light.spot();
+	const glm::vec3 axis = glm::normalize(glm::mat3(view) * light.direction);
+	const float cosAngle = light.outerCutOff;
+	const float sinAngle = std::sqrt(std::max(0.0f, 1.0f - cosAngle * cosAngle));
+	auto insideCone = [&](const glm::vec3 &boxCenter, float boxRadius)
+	{
+		glm::vec3 v = boxCenter - center;
+		float along = glm::dot(v, axis);
+		float across = std::sqrt(std::max(0.0f, glm::dot(v, v) - along * along));
+		if (cosAngle * across - along * sinAngle > boxRadius)
+			return false; // Outside the cone's sides.
+		if (along < -boxRadius)
+			return false; // Behind the apex.
+		return !bounded || along <= radius + boxRadius;
+	};
+	// Room for every froxel of the range up front, so the loops below write through a plain pointer.
+	const size_t first = hits.size();
+	hits.resize(first + static_cast<size_t>(s1 - s0 + 1) * (y1 - y0 + 1) * (x1 - x0 + 1));
+	glm::uvec2 *out = hits.data() + first;
+	auto addToCluster = [&](int x, int y, int s, size_t row, const float *rowMinX, const float *rowMaxX)
+	{
+		if (spot)
+		{
+			glm::vec3 lo(rowMinX[x], minY[row], -sliceFar[s]);
+			glm::vec3 hi(rowMaxX[x], maxY[row], -sliceNear[s]);
+			// The last slice reaches the far plane; its sphere would cover everything anyway.
+			if (s + 1 < settings.slices && !insideCone((lo + hi) * 0.5f, glm::length(hi - lo) * 0.5f))
+				return;
+		}
+		size_t cluster = clusterIndex(x, y, s);
+		*out++ = glm::uvec2(static_cast<uint32_t>(cluster), index);
+		++counts[cluster];
+	};
+
+	for (int s = s0; s <= s1; ++s)
+	{
+		float dz = depth < sliceNear[s] ? sliceNear[s] - depth : (depth > sliceFar[s] ? depth - sliceFar[s] : 0.0f);
+		if (bounded && dz * dz > radiusSq)
+			continue;
+		for (int y = y0; y <= y1; ++y)
+		{
+			const size_t row = static_cast<size_t>(s) * settings.tilesY + y;
+			float dy = std::max({minY[row] - center.y, center.y - maxY[row], 0.0f});
+			float dyz = dy * dy + dz * dz;
+			if (bounded && dyz > radiusSq)
+				continue;
+			const float *rowMinX = &minX[static_cast<size_t>(s) * settings.tilesX];
+			const float *rowMaxX = &maxX[static_cast<size_t>(s) * settings.tilesX];
+#ifdef PG2_SSE
+			// Sphere against the boxes of four tiles at a time; lanes past x1 are masked off.
+			const __m128 cx = _mm_set1_ps(center.x);
+			const __m128 yz = _mm_set1_ps(dyz), reach = _mm_set1_ps(radiusSq);
+			for (int x = x0; x <= x1; x += 4)
+			{
+				int mask = (1 << std::min(x1 - x + 1, 4)) - 1;
+				if (bounded)
+				{
+					__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(rowMinX + x), cx), _mm_sub_ps(cx, _mm_loadu_ps(rowMaxX + x))),
+										   _mm_setzero_ps());
+					mask &= _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), yz), reach));
+				}
+				for (int lane = 0; mask != 0; ++lane, mask >>= 1)
+				{
+					if (mask & 1)
+						addToCluster(x + lane, y, s, row, rowMinX, rowMaxX);
+				}
+			}
+#else
+			for (int x = x0; x <= x1; ++x)
+			{
+				float dx = std::max({rowMinX[x] - center.x, center.x - rowMaxX[x], 0.0f});
+				if (bounded && dx * dx + dyz > radiusSq)
+					continue;
+				addToCluster(x, y, s, row, rowMinX, rowMaxX);
+			}
+#endif
+		}
+	}
+	hits.resize(static_cast<size_t>(out - hits.data()));
+}
+
+void LightClusters::build(const glm::mat4 &view, const std::vector<ClusterLight> &lights)
+{
+	const size_t clusters = clusterCount();
+	counts.assign(clusters, 0);
+	hits.clear();
+	for (size_t i = 0; i < lights.size(); ++i)
+		addLight(static_cast<uint32_t>(i), lights[i], view);
+
+	// Counting sort of the (cluster, light) pairs; lights stay in order within a cluster.
+	lastStats = Stats();
+	lastStats.lights = lights.size();
+	lastStats.references = hits.size();
+	clusterRanges.resize(clusters);
+	uint32_t offset = 0;
+	for (size_t c = 0; c < clusters; ++c)
+	{
+		clusterRanges[c] = glm::uvec2(offset, counts[c]);
+		lastStats.maxPerCluster = std::max<size_t>(lastStats.maxPerCluster, counts[c]);
+		lastStats.occupiedClusters += counts[c] > 0 ? 1 : 0;
+		counts[c] = offset;
+		offset += clusterRanges[c].y;
+	}
+	lightIndices.resize(hits.size());
+	for (const glm::uvec2 &hit : hits)
+		lightIndices[counts[hit.x]++] = hit.y;
+}
+
+std::vector<ClusterLight> generateLightField(size_t count, const AABB &area, float range, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<ClusterLight> lights(count);
+	for (ClusterLight &light : lights)
+	{
+		light.position = area.min + (area.max - area.min) * glm::vec3(unit(rng), unit(rng), unit(rng));
+
+		// Saturated colour from a random hue.
+		float hue = unit(rng) * 6.0f;
+		glm::vec3 color = glm::clamp(glm::vec3(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f),
+											   2.0f - std::abs(hue - 4.0f)),
+									 0.0f, 1.0f);
+		light.diffuse = color;
+		light.specular = color * 0.5f;
+
+		// Inverse-square falloff reaching kLightCutoff at range.
+		light.constant = 1.0f;
+		light.linear = 0.0f;
+		light.quadratic = (1.0f / kLightCutoff - 1.0f) / (range * range);
+		light.range = lightRange(light);
+	}
+	return lights;
+}
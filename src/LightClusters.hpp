@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+
+// Point or spot light as read by basic.frag (std430 ClusterLight). Every vec3 is followed by
+// a float so each pair fills one 16-byte slot.
+struct ClusterLight
+{
+    glm::vec3 position{0.0f};
+    float range{0.0f};          // Distance where the light is cut off; 0 = unbounded (no attenuation).
+    glm::vec3 direction{0.0f, 0.0f, -1.0f};
+    float cutOff{-2.0f};        // Cosines of the spot cone; below -1 for point lights.
+    glm::vec3 ambient{0.0f};
+    float outerCutOff{-2.0f};
+    glm::vec3 diffuse{0.0f};
+    float constant{1.0f};
+    glm::vec3 specular{0.0f};
+    float linear{0.0f};
+    float quadratic{0.0f};
+    float pad0[3]{};
+
+    bool spot() const { return outerCutOff >= -1.0f; }
+};
+static_assert(sizeof(ClusterLight) == 96, "ClusterLight must match the std430 ClusterLight");
+
+// Fraction of a light's peak intensity below which it is treated as dark (sets ClusterLight::range).
+constexpr float kLightCutoff = 0.01f;
+
+// Distance at which 1 / (constant + linear d + quadratic d^2) scaled by the light's brightest
+// channel drops to kLightCutoff; 0 if it never does.
+float lightRange(const ClusterLight &light);
+
+// Clustered light culling. The view frustum is split into tilesX x tilesY screen tiles and
+// slices exponentially spaced depth slices (froxels); every frame each light is tested against
+// the view-space boxes of the froxels its bounding sphere (and, for spots, its cone) can reach,
+// and the result is flattened into one index list:
+//
+//   ranges[cluster] = {first, count} into indices, indices[...] = light index
+//
+// basic.frag finds the froxel of a fragment from gl_FragCoord and its view depth and walks only
+// that froxel's lights. Depths past farDepth all fall into the last slice.
+class LightClusters
+{
+public:
+    struct Settings
+    {
+        int tilesX = 16;
+        int tilesY = 9;
+        int slices = 24;
+        float farDepth = 250.0f; // View depth where the last slice begins to extend to the far plane.
+    };
+
+    struct Stats
+    {
+        size_t lights = 0;     // Lights given to the last build().
+        size_t references = 0; // Light indices written (sum of all cluster counts).
+        size_t maxPerCluster = 0;
+        size_t occupiedClusters = 0;
+    };
+
+    LightClusters() = default;
+    explicit LightClusters(const Settings &settings) : settings(settings) {}
+
+    // Takes the frustum from a glm::perspective matrix and the framebuffer size. Cheap when unchanged.
+    void setProjection(const glm::mat4 &projection, int width, int height);
+
+    // Assigns the lights (world space) to the clusters of the view.
+    void build(const glm::mat4 &view, const std::vector<ClusterLight> &lights);
+
+    size_t clusterCount() const { return static_cast<size_t>(settings.tilesX) * settings.tilesY * settings.slices; }
+    const std::vector<glm::uvec2> &ranges() const { return clusterRanges; }
+    const std::vector<uint32_t> &indices() const { return lightIndices; }
+    const Settings &config() const { return settings; }
+    const Stats &stats() const { return lastStats; }
+
+    // Shader parameters: tile size in pixels and slice = log(depth) * sliceScale + sliceBias.
+    glm::vec2 tileSize() const { return tilePixels; }
+    float sliceScale() const { return logScale; }
+    float sliceBias() const { return logBias; }
+
+private:
+    Settings settings;
+    glm::mat4 lastProjection{0.0f};
+    int viewportWidth = 0, viewportHeight = 0;
+    float nearDepth = 0.1f, farPlane = 1000.0f;
+    float tanHalfX = 1.0f, tanHalfY = 1.0f;
+    glm::vec2 tilePixels{1.0f};
+    float logScale = 1.0f, logBias = 0.0f;
+
+    // View-space cluster boxes. A box's x extent depends only on its tile column and slice, its y
+    // extent on its row and slice and its depth extent on its slice, so they are stored per
+    // (slice, column), (slice, row) and slice in flat arrays the per-row loop walks linearly.
+    std::vector<float> minX, maxX; // [slice * tilesX + x]
+    std::vector<float> minY, maxY; // [slice * tilesY + y]
+    std::vector<float> sliceNear, sliceFar;
+    std::vector<float> tileNdcX, tileNdcY; // Tile edges in NDC, tilesX + 1 and tilesY + 1 entries.
+
+    std::vector<uint32_t> counts;
+    std::vector<glm::uvec2> hits; // (cluster, light) pairs of the current build.
+    std::vector<glm::uvec2> clusterRanges;
+    std::vector<uint32_t> lightIndices;
+    Stats lastStats;
+
+    size_t clusterIndex(int x, int y, int slice) const
+    {
+        return (static_cast<size_t>(slice) * settings.tilesY + y) * settings.tilesX + x;
+    }
+    int sliceOf(float depth) const;
+    static int tileOf(float ndc, int tiles, int pixels, float tileSize);
+    void addLight(uint32_t index, const ClusterLight &light, const glm::mat4 &view);
+};
+
+// Benchmark scene: count coloured point lights scattered over area with a fixed seed, spaced at
+// heights between area.min.y and area.max.y and reaching about range units.
+std::vector<ClusterLight> generateLightField(size_t count, const AABB &area, float range = 4.0f, uint32_t seed = 1234);
@@ -0,0 +1,140 @@
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(opened_, other.opened_);
+#ifdef _WIN32
+		std::swap(file_, other.file_);
+		std::swap(mapping_, other.mapping_);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path &path)
+{
+	close();
+
+	HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+							  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	file_ = file;
+	opened_ = true;
+	size_ = static_cast<size_t>(size.QuadPart);
+	if (size_ == 0)
+		return true; // Empty files cannot be mapped, but are valid.
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	mapping_ = mapping;
+
+	data_ = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_ != nullptr)
+		UnmapViewOfFile(data_);
+	if (mapping_ != nullptr)
+		CloseHandle(mapping_);
+	if (file_ != nullptr)
+		CloseHandle(file_);
+	data_ = nullptr;
+	mapping_ = nullptr;
+	file_ = nullptr;
+	size_ = 0;
+	opened_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path &path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	size_ = static_cast<size_t>(st.st_size);
+	if (size_ > 0)
+	{
+		void *ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED)
+		{
+			::close(fd);
+			size_ = 0;
+			return false;
+		}
+		// The whole file is scanned front to back.
+		madvise(ptr, size_, MADV_SEQUENTIAL);
+		data_ = static_cast<const char *>(ptr);
+	}
+
+	// The mapping keeps its own reference to the file.
+	::close(fd);
+	opened_ = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_ != nullptr)
+		munmap(const_cast<char *>(data_), size_);
+	data_ = nullptr;
+	size_ = 0;
+	opened_ = false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, file mapping on Windows).
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path &path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // Maps the file; returns false if it cannot be opened or mapped.
+    bool open(const std::filesystem::path &path);
+
+    // Unmaps the file (safe to call repeatedly).
+    void close();
+
+    bool isOpen() const { return opened_; }
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    const char *begin() const { return data_; }
+    const char *end() const { return data_ + size_; }
+
+private:
+    const char *data_{nullptr}; // Start of the mapping (nullptr for empty files).
+    size_t size_{0};            // Length of the file in bytes.
+    bool opened_{false};        // True once open() succeeded, even for empty files.
+#ifdef _WIN32
+    void *file_{nullptr};    // HANDLE of the opened file.
+    void *mapping_{nullptr}; // HANDLE of the file mapping object.
+#endif
+};
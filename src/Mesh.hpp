@@ -7,10 +7,12 @@
 #include <glm/ext.hpp>
 
 #include "assets.hpp"
+#include "AssetManager.hpp"
+#include "MeshOptimizer.hpp"
 #include "ShaderProgram.hpp"
-#include <opencv2/opencv.hpp>
+#include "UniformBlocks.hpp"
 
-// Represents a 3D mesh with vertex data, material properties, and OpenGL resources.
+// Represents a drawable mesh: shared GPU geometry and texture handles plus material properties.
 class Mesh
 {
 public:
@@ -19,9 +21,10 @@ public:
     glm::vec3 orientation{}; // Euler angles (degrees) for mesh rotation.
 
     // OpenGL rendering properties.
-    GLuint texture_id{0};  // ID of the texture; 0 indicates no texture.
-    GLenum primitive_type; // OpenGL primitive type (e.g., GL_TRIANGLES, GL_POINTS).
-    ShaderProgram shader;  // Shader program for rendering the mesh.
+    GLenum primitive_type;   // OpenGL primitive type (e.g., GL_TRIANGLES, GL_POINTS).
+    ShaderProgram shader;    // Shader program for rendering the mesh.
+    GeometryHandle geometry; // Shared VAO/VBO/EBO; nullptr until initialized.
+    TextureHandle texture;   // Shared texture; nullptr indicates no texture.
 
     // Material properties for lighting calculations.
     glm::vec4 ambient_material{1.0f};  // Ambient color and opacity (RGBA, default white).
@@ -29,14 +32,16 @@ public:
     glm::vec4 specular_material{1.0f}; // Specular color and opacity (RGBA, default white).
     float reflectivity{1.0f};          // Shininess factor for specular highlights.
 
+    // Uniform handles used while drawing, resolved once from the shader's reflection table.
+    struct Uniforms
+    {
+        UniformHandle model, sampler, instanced, textureLayer, weightedOIT;
+    } uniforms;
+
     // Default constructor initializing a mesh with safe defaults.
     Mesh()
         : primitive_type(GL_POINTS), // Default to point rendering.
           shader(),                  // Initialize shader with invalid ID (0).
-          texture_id(0),             // No texture by default.
-          VAO(0),                    // Uninitialized VAO.
-          VBO(0),                    // Uninitialized VBO.
-          EBO(0),                    // Uninitialized EBO.
           origin(0.0f),              // Origin at (0,0,0).
           orientation(0.0f),         // No rotation.
           ambient_material(1.0f),    // White, opaque ambient material.
@@ -47,114 +52,63 @@ public:
         // Defer OpenGL resource creation to avoid context issues.
     }
 
-    // Constructor for indexed drawing with vertex and index data.
+    // Constructor for indexed drawing with vertex and index data (geometry is not shared).
     Mesh(GLenum primitive_type, ShaderProgram shader, std::string texturePath,
          std::vector<Vertex> const &vertices, std::vector<GLuint> const &indices,
-         glm::vec3 const &origin, glm::vec3 const &orientation, GLuint const texture_id = 0)
+         glm::vec3 const &origin, glm::vec3 const &orientation)
         : primitive_type(primitive_type),
           shader(shader),
-          texture_id(texture_id),
-          vertices(vertices),
-          indices(indices),
           origin(origin),
           orientation(orientation)
     {
-        // Create and bind Vertex Array Object (VAO).
-        glCreateVertexArrays(1, &VAO);
-        if (VAO == 0)
-        {
-            std::cerr << "Error: Failed to create VAO\n";
-            throw std::runtime_error("VAO creation failed");
-        }
-
-        // Validate shader program.
-        GLuint shader_prog_ID = shader.getID();
-        if (shader_prog_ID == 0)
-        {
-            std::cerr << "Error: Invalid shader program ID\n";
-            throw std::runtime_error("Invalid shader program");
-        }
-
-        // Configure position attribute.
-        GLint position_attrib_location = glGetAttribLocation(shader_prog_ID, "attribute_Position");
-        if (position_attrib_location == -1)
-        {
-            std::cerr << "Error: Shader lacks 'attribute_Position'\n";
-            throw std::runtime_error("Invalid position attribute");
-        }
-        glEnableVertexArrayAttrib(VAO, position_attrib_location);
-        glVertexArrayAttribFormat(VAO, position_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
-        glVertexArrayAttribBinding(VAO, position_attrib_location, 0);
-
-        // Configure normal attribute if used by shader.
-        GLint normal_attrib_location = glGetAttribLocation(shader_prog_ID, "attribute_Normal");
-        if (normal_attrib_location != -1)
-        {
-            glEnableVertexArrayAttrib(VAO, normal_attrib_location);
-            glVertexArrayAttribFormat(VAO, normal_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
-            glVertexArrayAttribBinding(VAO, normal_attrib_location, 0);
-        }
-
-        // Configure texture coordinate attribute if used by shader.
-        GLint texcoord_attrib_location = glGetAttribLocation(shader_prog_ID, "attribute_TexCoords");
-        if (texcoord_attrib_location != -1)
+        AssetManager &assets = AssetManager::instance();
+        if (fitsShortIndices(vertices.size()))
         {
-            glEnableVertexArrayAttrib(VAO, texcoord_attrib_location);
-            glVertexArrayAttribFormat(VAO, texcoord_attrib_location, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
-            glVertexArrayAttribBinding(VAO, texcoord_attrib_location, 0);
+            // Halve the index buffer when every vertex is addressable with 16 bits.
+            std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+            geometry = assets.createGeometry(shader.getID(), vertices.data(), vertices.size(),
+                                             shortIndices.data(), shortIndices.size(), GL_UNSIGNED_SHORT);
         }
-
-        // Create and upload Vertex Buffer Object (VBO).
-        glCreateBuffers(1, &VBO);
-        if (VBO == 0)
+        else
         {
-            std::cerr << "Error: Failed to create VBO\n";
-            glDeleteVertexArrays(1, &VAO);
-            throw std::runtime_error("VBO creation failed");
+            geometry = assets.createGeometry(shader.getID(), vertices.data(), vertices.size(),
+                                             indices.data(), indices.size(), GL_UNSIGNED_INT);
         }
-        glNamedBufferData(VBO, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
-        // Create and upload Element Buffer Object (EBO).
-        glCreateBuffers(1, &EBO);
-        if (EBO == 0)
+        // Load texture if a valid path is provided (textures are shared by path).
+        if (!texturePath.empty())
         {
-            std::cerr << "Error: Failed to create EBO\n";
-            glDeleteBuffers(1, &VBO);
-            glDeleteVertexArrays(1, &VAO);
-            throw std::runtime_error("EBO creation failed");
+            texture = assets.loadTexture(texturePath);
         }
-        glNamedBufferData(EBO, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
-        // Link VBO and EBO to VAO.
-        glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Vertex));
-        glVertexArrayElementBuffer(VAO, EBO);
+        resolveUniforms();
+    }
 
-        // Load texture if a valid path is provided.
-        if (!texturePath.empty())
-        {
-            loadTexture(texturePath);
-        }
+    // Constructor for already loaded (usually shared) geometry and texture.
+    Mesh(GLenum primitive_type, ShaderProgram shader, GeometryHandle geometry, TextureHandle texture,
+         glm::vec3 const &origin = glm::vec3(0.0f), glm::vec3 const &orientation = glm::vec3(0.0f))
+        : primitive_type(primitive_type),
+          shader(shader),
+          geometry(std::move(geometry)),
+          texture(std::move(texture)),
+          origin(origin),
+          orientation(orientation)
+    {
+        resolveUniforms();
     }
 
     // Returns the Vertex Array Object ID.
-    GLuint getVAO() const { return VAO; }
+    GLuint getVAO() const { return geometry ? geometry->VAO : 0; }
 
     // Returns the number of indices for indexed drawing.
-    GLsizei getIndexCount() const { return static_cast<GLsizei>(indices.size()); }
-
-    // Renders the mesh with specified transformations.
-    void draw(glm::vec3 const &offset, glm::vec3 const &rotation, bool isSun = false) const
-    {
-        if (VAO == 0)
-        {
-            std::cerr << "Error: VAO not initialized\n";
-            return;
-        }
+    GLsizei getIndexCount() const { return geometry ? geometry->index_count : 0; }
 
-        // Activate shader program.
-        shader.activate();
+    // Returns the object-space bounds of the geometry (empty if there is none).
+    AABB getLocalBounds() const { return geometry ? geometry->bounds : AABB(); }
 
-        // Compute model matrix with translation, rotation, and scaling.
+    // Computes the world matrix for the given model offset and rotation (Euler degrees).
+    glm::mat4 getModelMatrix(glm::vec3 const &offset, glm::vec3 const &rotation) const
+    {
         glm::mat4 modelMatrix = glm::mat4(1.0f);
         modelMatrix = glm::translate(modelMatrix, origin + offset);
         modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -164,53 +118,84 @@ public:
         modelMatrix = glm::rotate(modelMatrix, glm::radians(orientation.y), glm::vec3(0.0f, 1.0f, 0.0f));
         modelMatrix = glm::rotate(modelMatrix, glm::radians(orientation.z), glm::vec3(0.0f, 0.0f, 1.0f));
         modelMatrix = glm::scale(modelMatrix, glm::vec3(0.5f)); // Uniform scale factor.
+        return modelMatrix;
+    }
 
-        // Upload model matrix to shader.
-        GLint modelLoc = glGetUniformLocation(shader.getID(), "uM_m");
-        if (modelLoc != -1)
+    // Returns the material buffer entry for the current material values (re-interned when they change).
+    GLuint getMaterialIndex() const
+    {
+        MaterialData material;
+        material.ambient = glm::vec3(ambient_material);
+        material.diffuse = glm::vec3(diffuse_material);
+        material.specular = glm::vec3(specular_material);
+        material.shininess = reflectivity;
+        if (!materialValid || material != cachedMaterial)
+        {
+            materialIndex = MaterialBuffer::instance().acquire(material);
+            cachedMaterial = material;
+            materialValid = true;
+        }
+        return materialIndex;
+    }
+
+    // Activates the shader and binds the material and texture.
+    void applyMaterial() const
+    {
+        // Activate shader program.
+        shader.activate();
+
+        // Bind this mesh's entry of the shared material buffer.
+        MaterialBuffer::instance().bind(getMaterialIndex());
+
+        // Bind texture if available (its array and layer once packed).
+        if (texture)
         {
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+            texture->bind();
+            shader.setUniform(uniforms.sampler, static_cast<int>(kTextureUnit));
         }
-        else
+        shader.setUniform(uniforms.textureLayer, texture ? texture->layer : -1);
+    }
+
+    // Renders the mesh with specified transformations.
+    void draw(glm::vec3 const &offset, glm::vec3 const &rotation, bool isSun = false) const
+    {
+        if (!geometry)
         {
-            std::cerr << "Warning: Shader uniform 'uM_m' not found\n";
+            std::cerr << "Error: VAO not initialized\n";
+            return;
         }
 
-        // Upload material properties to shader.
-        GLint matAmbientLoc = glGetUniformLocation(shader.getID(), "material.ambient");
-        if (matAmbientLoc != -1)
-            glUniform3fv(matAmbientLoc, 1, glm::value_ptr(glm::vec3(ambient_material)));
-
-        GLint matDiffuseLoc = glGetUniformLocation(shader.getID(), "material.diffuse");
-        if (matDiffuseLoc != -1)
-            glUniform3fv(matDiffuseLoc, 1, glm::value_ptr(glm::vec3(diffuse_material)));
+        applyMaterial();
 
-        GLint matSpecularLoc = glGetUniformLocation(shader.getID(), "material.specular");
-        if (matSpecularLoc != -1)
-            glUniform3fv(matSpecularLoc, 1, glm::value_ptr(glm::vec3(specular_material)));
-
-        GLint matShininessLoc = glGetUniformLocation(shader.getID(), "material.shininess");
-        if (matShininessLoc != -1)
-            glUniform1f(matShininessLoc, reflectivity);
-
-        // Bind texture if available.
-        if (texture_id != 0)
+        // Upload model matrix to shader.
+        if (uniforms.model.valid())
         {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texture_id);
-            glUniform1i(glGetUniformLocation(shader.getID(), "textureSampler"), 0);
+            shader.setUniform(uniforms.model, getModelMatrix(offset, rotation));
+        }
+        else
+        {
+            std::cerr << "Warning: Shader uniform 'uM_m' not found\n";
         }
 
         // Draw the mesh using indexed rendering.
-        glBindVertexArray(VAO);
-        glDrawElements(primitive_type, getIndexCount(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(geometry->VAO);
+        glDrawElements(primitive_type, getIndexCount(), geometry->index_type, 0);
+    }
+
+    // Draws instanceCount copies whose model matrices start at baseInstance in the
+    // instance buffer. The program, material, texture and VAO must already be bound.
+    void drawInstanced(GLsizei instanceCount, GLuint baseInstance) const
+    {
+        if (!geometry)
+            return;
+        glDrawElementsInstancedBaseInstance(primitive_type, getIndexCount(), geometry->index_type, nullptr,
+                                            instanceCount, baseInstance);
     }
 
-    // Releases OpenGL resources and resets member variables.
+    // Drops the GPU resource handles and resets member variables.
     void clear()
     {
         // Reset member variables to defaults.
-        texture_id = 0;
         primitive_type = GL_POINTS;
         origin = glm::vec3(0.0f);
         orientation = glm::vec3(0.0f);
@@ -218,98 +203,26 @@ public:
         diffuse_material = glm::vec4(1.0f);
         specular_material = glm::vec4(1.0f);
         reflectivity = 1.0f;
-        vertices.clear();
-        indices.clear();
 
-        // Clean up OpenGL resources.
-        if (EBO != 0)
-        {
-            glDeleteBuffers(1, &EBO);
-            EBO = 0;
-        }
-        if (VBO != 0)
-        {
-            glDeleteBuffers(1, &VBO);
-            VBO = 0;
-        }
-        if (VAO != 0)
-        {
-            glDeleteVertexArrays(1, &VAO);
-            VAO = 0;
-        }
+        // GL objects are released once no other mesh holds them.
+        geometry.reset();
+        texture.reset();
+        uniforms = Uniforms();
+        materialValid = false;
     }
 
 private:
-    // OpenGL resource IDs (0 indicates uninitialized).
-    unsigned int VAO{0}; // Vertex Array Object.
-    unsigned int VBO{0}; // Vertex Buffer Object.
-    unsigned int EBO{0}; // Element Buffer Object.
-
-    // Mesh geometry data.
-    std::vector<Vertex> vertices; // Vertex attributes (position, normal, texcoords).
-    std::vector<GLuint> indices;  // Indices for indexed drawing.
+    // Material buffer entry of the values last drawn with.
+    mutable MaterialData cachedMaterial;
+    mutable GLuint materialIndex = 0;
+    mutable bool materialValid = false;
 
-    // Loads a texture from a file or creates a default texture.
-    void loadTexture(const std::string &texturePath)
+    void resolveUniforms()
     {
-        if (texturePath == "NONE")
-        {
-            // Create a 1x1 yellow texture.
-            unsigned char yellow[] = {255, 255, 0, 255};
-            glGenTextures(1, &texture_id);
-            glBindTexture(GL_TEXTURE_2D, texture_id);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, yellow);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            return;
-        }
-
-        if (texturePath.empty())
-        {
-            // Create a 1x1 white texture.
-            unsigned char white[] = {255, 255, 255, 255};
-            glGenTextures(1, &texture_id);
-            glBindTexture(GL_TEXTURE_2D, texture_id);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            return;
-        }
-
-        // Load texture image using OpenCV.
-        cv::Mat image = cv::imread(texturePath, cv::IMREAD_UNCHANGED);
-        if (image.empty())
-        {
-            std::cerr << "Error: Failed to load texture: " << texturePath << "\n";
-            return;
-        }
-
-        // Flip image vertically to match OpenGL's bottom-left origin.
-        cv::flip(image, image, 0);
-
-        // Create and configure texture.
-        glGenTextures(1, &texture_id);
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Upload texture data based on channel count.
-        if (image.channels() == 4)
-        {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.cols, image.rows, 0, GL_BGRA, GL_UNSIGNED_BYTE, image.data);
-            std::cout << "Loaded texture with alpha channel\n";
-        }
-        else
-        {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.cols, image.rows, 0, GL_BGR, GL_UNSIGNED_BYTE, image.data);
-        }
-
-        // Generate mipmaps and unbind texture.
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        uniforms.model = shader.uniform("uM_m");
+        uniforms.sampler = shader.uniform("textureSampler");
+        uniforms.instanced = shader.uniform("uInstanced");
+        uniforms.textureLayer = shader.uniform("uTextureLayer");
+        uniforms.weightedOIT = shader.uniform("uWeightedOIT");
     }
 };
@@ -0,0 +1,270 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "OBJloader.hpp"
+
+const std::filesystem::path MeshCache::defaultDirectory = "cache/meshes";
+MeshCache::Stats MeshCache::stats;
+
+namespace
+{
+	uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t hashPath(const std::filesystem::path &source)
+	{
+		std::string key = source.lexically_normal().generic_string();
+		return fnv1a(key.data(), key.size());
+	}
+
+	// Hashes the contents of a file through a read-only mapping.
+	bool hashFile(const std::filesystem::path &path, uint64_t &hash)
+	{
+		MappedFile file;
+		if (!file.open(path))
+			return false;
+		hash = fnv1a(file.data(), file.size());
+		return true;
+	}
+
+	int64_t mtimeOf(const std::filesystem::path &path)
+	{
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Writes to a temporary file first so a crash never leaves a torn entry behind.
+	bool writeFile(const std::filesystem::path &target, const std::vector<char> &image)
+	{
+		std::error_code ec;
+		if (target.has_parent_path())
+			std::filesystem::create_directories(target.parent_path(), ec);
+
+		std::filesystem::path temp = target;
+		temp += ".tmp";
+		{
+			std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+			if (!out)
+				return false;
+			out.write(image.data(), static_cast<std::streamsize>(image.size()));
+			if (!out)
+				return false;
+		}
+		std::filesystem::rename(temp, target, ec);
+		if (ec)
+		{
+			std::filesystem::remove(temp, ec);
+			return false;
+		}
+		return true;
+	}
+}
+
+std::filesystem::path MeshCache::entryPath(const std::filesystem::path &source, const std::filesystem::path &cacheDir)
+{
+	std::ostringstream name;
+	name << source.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << hashPath(source) << ".pgmesh";
+	return cacheDir / name.str();
+}
+
+bool MeshCache::buildImage(const std::filesystem::path &source, std::vector<char> &image)
+{
+	std::vector<glm::vec3> out_vertices;
+	std::vector<glm::vec2> out_uvs;
+	std::vector<glm::vec3> out_normals;
+	if (!loadOBJ(source.string().c_str(), out_vertices, out_uvs, out_normals))
+		return false;
+
+	std::vector<Vertex> unrolled(out_vertices.size());
+	for (size_t i = 0; i < out_vertices.size(); ++i)
+	{
+		unrolled[i].Position = out_vertices[i];
+		unrolled[i].Normal = out_normals[i];
+		unrolled[i].TexCoords = out_uvs[i];
+	}
+
+	// Weld, then reorder for the post-transform cache and fetch locality.
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	weldVertices(unrolled, vertices, indices);
+	float acmrBefore = computeACMR(indices, vertices.size());
+	optimizeMesh(vertices, indices);
+
+	MeshFileHeader header{};
+	std::memcpy(header.magic, "PGMC", 4);
+	header.version = kMeshFileVersion;
+	header.vertexStride = sizeof(Vertex);
+	header.indexSize = fitsShortIndices(vertices.size()) ? 2 : 4;
+	header.vertexCount = vertices.size();
+	header.indexCount = indices.size();
+	std::error_code ec;
+	header.sourceSize = std::filesystem::file_size(source, ec);
+	header.sourceMtime = mtimeOf(source);
+	if (ec || !hashFile(source, header.sourceHash))
+		return false;
+	header.pathHash = hashPath(source);
+
+	glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+	if (!vertices.empty())
+	{
+		boundsMin = boundsMax = vertices[0].Position;
+		for (const Vertex &v : vertices)
+		{
+			boundsMin = glm::min(boundsMin, v.Position);
+			boundsMax = glm::max(boundsMax, v.Position);
+		}
+	}
+	for (int i = 0; i < 3; ++i)
+	{
+		header.boundsMin[i] = boundsMin[i];
+		header.boundsMax[i] = boundsMax[i];
+	}
+
+	size_t vertexBytes = vertices.size() * sizeof(Vertex);
+	size_t indexBytes = indices.size() * header.indexSize;
+	image.resize(sizeof(MeshFileHeader) + vertexBytes + indexBytes);
+	char *out = image.data();
+	std::memcpy(out, &header, sizeof(MeshFileHeader));
+	std::memcpy(out + sizeof(MeshFileHeader), vertices.data(), vertexBytes);
+	if (header.indexSize == 2)
+	{
+		std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		std::memcpy(out + sizeof(MeshFileHeader) + vertexBytes, shortIndices.data(), indexBytes);
+	}
+	else
+	{
+		std::memcpy(out + sizeof(MeshFileHeader) + vertexBytes, indices.data(), indexBytes);
+	}
+
+	std::cout << "Mesh cache: built " << source.filename().string() << ": " << unrolled.size() << " -> "
+			  << vertices.size() << " vertices, " << header.indexSize * 8 << "-bit indices, ACMR "
+			  << acmrBefore << " -> " << computeACMR(indices, vertices.size()) << "\n";
+	return true;
+}
+
+bool MeshCache::build(const std::filesystem::path &source, const std::filesystem::path &target)
+{
+	std::vector<char> image;
+	if (!buildImage(source, image))
+	{
+		std::cerr << "Error: Failed to convert " << source << "\n";
+		return false;
+	}
+	if (!writeFile(target, image))
+	{
+		std::cerr << "Error: Failed to write " << target << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::attach(const char *data, size_t size)
+{
+	header_ = nullptr;
+	vertices_ = nullptr;
+	indices_ = nullptr;
+	if (data == nullptr || size < sizeof(MeshFileHeader))
+		return false;
+
+	const MeshFileHeader *header = reinterpret_cast<const MeshFileHeader *>(data);
+	if (std::memcmp(header->magic, "PGMC", 4) != 0 || header->version != kMeshFileVersion ||
+		header->vertexStride != sizeof(Vertex) || (header->indexSize != 2 && header->indexSize != 4))
+		return false;
+
+	uint64_t vertexBytes = header->vertexCount * sizeof(Vertex);
+	uint64_t indexBytes = header->indexCount * header->indexSize;
+	if (sizeof(MeshFileHeader) + vertexBytes + indexBytes != size)
+		return false;
+
+	header_ = header;
+	vertices_ = reinterpret_cast<const Vertex *>(data + sizeof(MeshFileHeader));
+	indices_ = data + sizeof(MeshFileHeader) + vertexBytes;
+	return true;
+}
+
+bool MeshCache::open(const std::filesystem::path &source, const std::filesystem::path &cacheDir)
+{
+	auto start = std::chrono::steady_clock::now();
+	const std::filesystem::path entry = entryPath(source, cacheDir);
+
+	std::error_code ec;
+	uint64_t sourceSize = std::filesystem::file_size(source, ec);
+	if (ec)
+	{
+		std::cerr << "Error: Cannot read " << source << "\n";
+		return false;
+	}
+	int64_t sourceMtime = mtimeOf(source);
+
+	if (file_.open(entry) && attach(file_.data(), file_.size()) &&
+		header_->pathHash == hashPath(source) && header_->sourceSize == sourceSize)
+	{
+		if (header_->sourceMtime == sourceMtime)
+		{
+			++stats.hits;
+			stats.loadMs += millisecondsSince(start);
+			return true;
+		}
+
+		// Touched but possibly unchanged (e.g. a fresh checkout): compare contents.
+		uint64_t sourceHash = 0;
+		if (hashFile(source, sourceHash) && sourceHash == header_->sourceHash)
+		{
+			MeshFileHeader refreshed = *header_;
+			refreshed.sourceMtime = sourceMtime;
+			file_.close();
+			{
+				std::fstream patch(entry, std::ios::in | std::ios::out | std::ios::binary);
+				patch.write(reinterpret_cast<const char *>(&refreshed), sizeof(refreshed));
+			}
+			if (file_.open(entry) && attach(file_.data(), file_.size()))
+			{
+				++stats.hits;
+				stats.loadMs += millisecondsSince(start);
+				return true;
+			}
+		}
+	}
+
+	// Missing, stale or corrupt: regenerate.
+	file_.close();
+	header_ = nullptr;
+	std::vector<char> image;
+	if (!buildImage(source, image))
+		return false;
+
+	if (!(writeFile(entry, image) && file_.open(entry) && attach(file_.data(), file_.size())))
+	{
+		std::cerr << "Warning: Mesh cache not writable, keeping " << source.filename().string() << " in memory\n";
+		file_.close();
+		memory_ = std::move(image);
+		attach(memory_.data(), memory_.size());
+	}
+
+	++stats.rebuilds;
+	stats.buildMs += millisecondsSince(start);
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "assets.hpp"
+#include "MappedFile.hpp"
+
+// Binary mesh cache: each OBJ is parsed, welded and optimized once, then stored as a
+// "<stem>-<hash>.pgmesh" file laid out exactly as the GPU wants it:
+//
+//   [MeshFileHeader][Vertex x vertexCount][index x indexCount (uint16 or uint32)]
+//
+// At runtime the file is memory-mapped and the two arrays go straight to glNamedBufferData.
+// An entry is reused when the source path, size and mtime match, or when the content hash
+// still matches after the mtime changed; otherwise it is regenerated.
+
+constexpr uint32_t kMeshFileVersion = 1;
+
+struct MeshFileHeader
+{
+    char magic[4];          // "PGMC".
+    uint32_t version;       // kMeshFileVersion.
+    uint32_t vertexStride;  // sizeof(Vertex) at write time.
+    uint32_t indexSize;     // 2 (GL_UNSIGNED_SHORT) or 4 (GL_UNSIGNED_INT).
+    uint64_t vertexCount;   // Number of welded vertices.
+    uint64_t indexCount;    // Number of indices (triangle list).
+    uint64_t sourceSize;    // Size of the source OBJ in bytes.
+    int64_t sourceMtime;    // Source last_write_time (filesystem clock ticks).
+    uint64_t sourceHash;    // FNV-1a of the source contents.
+    uint64_t pathHash;      // FNV-1a of the source path.
+    float boundsMin[3];     // Object-space AABB minimum.
+    float boundsMax[3];     // Object-space AABB maximum.
+    uint32_t reserved[2];   // Keeps the vertex array 32-byte aligned.
+};
+static_assert(sizeof(MeshFileHeader) == 96, "MeshFileHeader layout changed; bump kMeshFileVersion");
+
+// One cached mesh, either mapped from disk or (if the cache is not writable) held in memory.
+class MeshCache
+{
+public:
+    // Default directory for cached meshes, relative to the working directory.
+    static const std::filesystem::path defaultDirectory;
+
+    // Counters for the current process, used for the cold/warm startup report.
+    struct Stats
+    {
+        unsigned hits = 0;      // Entries reused as-is.
+        unsigned rebuilds = 0;  // Entries (re)generated from the OBJ.
+        double buildMs = 0.0;   // Time spent regenerating.
+        double loadMs = 0.0;    // Time spent validating and mapping.
+    };
+    static Stats stats;
+
+    // Opens the cache entry for an OBJ file, rebuilding it when missing or stale.
+    bool open(const std::filesystem::path &source, const std::filesystem::path &cacheDir = defaultDirectory);
+
+    // Parses, welds and optimizes an OBJ and writes a .pgmesh file (used by pg2_meshconv).
+    static bool build(const std::filesystem::path &source, const std::filesystem::path &target);
+
+    // Location of the cache entry for a source file.
+    static std::filesystem::path entryPath(const std::filesystem::path &source, const std::filesystem::path &cacheDir);
+
+    const MeshFileHeader &header() const { return *header_; }
+    const Vertex *vertices() const { return vertices_; }
+    const void *indices() const { return indices_; }
+    size_t vertexCount() const { return static_cast<size_t>(header_->vertexCount); }
+    size_t indexCount() const { return static_cast<size_t>(header_->indexCount); }
+    bool shortIndices() const { return header_->indexSize == 2; }
+
+private:
+    MappedFile file_;
+    std::vector<char> memory_; // Fallback storage when the entry could not be written.
+    const MeshFileHeader *header_{nullptr};
+    const Vertex *vertices_{nullptr};
+    const void *indices_{nullptr};
+
+    // Builds the complete file image in memory.
+    static bool buildImage(const std::filesystem::path &source, std::vector<char> &image);
+
+    // Points header_/vertices_/indices_ into a validated file image.
+    bool attach(const char *data, size_t size);
+};
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include "MeshGenerators.hpp"
+#include "ParallelFor.hpp"
+
+// Rows per slice are chosen so a thread gets at least this many vertices; below that the
+// thread start costs more than the work.
+static constexpr size_t kMinVerticesPerThread = 16384;
+
+static size_t minRowsPerThread(size_t rowLength)
+{
+	return std::max<size_t>(1, kMinVerticesPerThread / std::max<size_t>(rowLength, 1));
+}
+
+// Two triangles per grid quad; quad (column, row) writes indices [6 * (row * quads + column), +6).
+static void writeGridIndices(uint32_t *out, size_t rowBegin, size_t rowEnd, uint32_t quads, uint32_t rowLength,
+							 bool sphereWinding)
+{
+	for (size_t row = rowBegin; row < rowEnd; ++row)
+	{
+		uint32_t *quad = out + row * quads * 6;
+		for (uint32_t column = 0; column < quads; ++column, quad += 6)
+		{
+			uint32_t first = static_cast<uint32_t>(row) * rowLength + column;
+			uint32_t second = first + rowLength;
+			if (sphereWinding)
+			{
+				quad[0] = first, quad[1] = second, quad[2] = first + 1;
+				quad[3] = second, quad[4] = second + 1, quad[5] = first + 1;
+			}
+			else
+			{
+				// topLeft -> bottomLeft -> topRight, topRight -> bottomLeft -> bottomRight
+				quad[0] = first, quad[1] = second, quad[2] = first + 1;
+				quad[3] = first + 1, quad[4] = second, quad[5] = second + 1;
+			}
+		}
+	}
+}
+
+void generateSphere(int segments, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, int threads)
+{
+	segments = std::max(segments, 1);
+	const size_t side = static_cast<size_t>(segments) + 1;
+	vertices.resize(side * side);
+	indices.resize(static_cast<size_t>(segments) * segments * 6);
+
+	const float PI = 3.1415926f;
+	Vertex *out = vertices.data();
+	parallelFor(side, [&](size_t begin, size_t end)
+				{
+		for (size_t i = begin; i < end; ++i)
+		{
+			float vAngle = PI * i / segments;
+			for (int j = 0; j <= segments; ++j)
+			{
+				float hAngle = 2 * PI * j / segments;
+				Vertex &vert = out[i * side + j];
+				vert.Position = glm::vec3(
+					sin(vAngle) * cos(hAngle),
+					cos(vAngle),
+					sin(vAngle) * sin(hAngle));
+				vert.Normal = vert.Position; // Normals are equal to positions for a unit sphere.
+				vert.TexCoords = glm::vec2(j / (float)segments, i / (float)segments);
+			}
+		} }, threads, minRowsPerThread(side));
+
+	parallelFor(static_cast<size_t>(segments), [&](size_t begin, size_t end)
+				{ writeGridIndices(indices.data(), begin, end, segments, static_cast<uint32_t>(side), true); },
+				threads, minRowsPerThread(side));
+}
+
+void generateHeightGrid(const HeightField &field, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
+						int threads)
+{
+	const int width = field.columns();
+	const int depth = field.rows();
+	vertices.resize(static_cast<size_t>(width) * depth);
+	indices.resize(static_cast<size_t>(std::max(width - 1, 0)) * std::max(depth - 1, 0) * 6);
+
+	Vertex *out = vertices.data();
+	parallelFor(static_cast<size_t>(depth), [&](size_t begin, size_t end)
+				{
+		for (int z = static_cast<int>(begin); z < static_cast<int>(end); ++z)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				Vertex &v = out[static_cast<size_t>(z) * width + x];
+				v.Position = glm::vec3(x - width / 2.0f, field.sampleHeight(x, z), z - depth / 2.0f);
+				v.TexCoords = glm::vec2(static_cast<float>(x) / (width - 1), static_cast<float>(z) / (depth - 1));
+				v.Normal = field.sampleNormal(x, z);
+			}
+		} }, threads, minRowsPerThread(width));
+
+	if (width > 1 && depth > 1)
+		parallelFor(static_cast<size_t>(depth - 1), [&](size_t begin, size_t end)
+					{ writeGridIndices(indices.data(), begin, end, width - 1, width, false); },
+					threads, minRowsPerThread(width));
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "HeightField.hpp"
+#include "assets.hpp"
+
+// Procedural mesh generators behind the Model constructors (CPU only, no GL calls).
+//
+// Both outputs are sized up front and filled row by row on parallelFor slices; every vertex and
+// every quad's six indices depend only on their own row and column, so the result is identical
+// for any thread count (threads <= 0 uses all hardware threads).
+
+// Unit sphere with (segments + 1)^2 vertices (normal = position) and two triangles per quad.
+void generateSphere(int segments, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, int threads = 0);
+
+// Grid mesh of a height field: one vertex per sample (centered like the field) and two
+// triangles per cell, with texture coordinates spanning the whole grid once.
+void generateHeightGrid(const HeightField &field, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
+                        int threads = 0);
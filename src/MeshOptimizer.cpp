@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cstring>
+
+#include "MeshOptimizer.hpp"
+
+namespace
+{
+	static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex is expected to be eight tightly packed floats");
+
+	// Copies a vertex with -0.0f turned into +0.0f, so equal values have equal bits.
+	inline Vertex canonical(const Vertex &v)
+	{
+		Vertex c;
+		c.Position = v.Position + glm::vec3(0.0f);
+		c.Normal = v.Normal + glm::vec3(0.0f);
+		c.TexCoords = v.TexCoords + glm::vec2(0.0f);
+		return c;
+	}
+
+	// FNV-1a over the raw bits of all eight components.
+	inline uint32_t hashVertex(const Vertex &v)
+	{
+		uint32_t words[8];
+		std::memcpy(words, &v, sizeof(words));
+		uint32_t h = 2166136261u;
+		for (uint32_t w : words)
+		{
+			h ^= w;
+			h *= 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+}
+
+void weldVertices(const std::vector<Vertex> &vertices, std::vector<Vertex> &out_vertices, std::vector<uint32_t> &out_indices)
+{
+	out_vertices.clear();
+	out_indices.resize(vertices.size());
+
+	// Open-addressing table of indices into out_vertices, at most half full.
+	size_t capacity = 16;
+	while (capacity < vertices.size() * 2)
+		capacity *= 2;
+	const uint32_t empty = UINT32_MAX;
+	std::vector<uint32_t> table(capacity, empty);
+	const size_t mask = capacity - 1;
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		Vertex v = canonical(vertices[i]);
+		size_t slot = hashVertex(v) & mask;
+		while (true)
+		{
+			uint32_t entry = table[slot];
+			if (entry == empty)
+			{
+				entry = static_cast<uint32_t>(out_vertices.size());
+				table[slot] = entry;
+				out_vertices.push_back(v);
+				out_indices[i] = entry;
+				break;
+			}
+			if (std::memcmp(&out_vertices[entry], &v, sizeof(Vertex)) == 0)
+			{
+				out_indices[i] = entry;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount, unsigned cacheSize)
+{
+	std::vector<uint32_t> clusters;
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return clusters;
+
+	// Vertex -> triangle adjacency in compressed (offset + list) form.
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices)
+		++liveCount[index];
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + liveCount[v];
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1; // Every vertex starts out of the cache.
+	size_t cursor = 0;             // Next vertex to try once the dead-end stack is empty.
+
+	auto nextFromDeadEnd = [&]() -> int64_t
+	{
+		while (!deadEnd.empty())
+		{
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveCount[v] > 0)
+				return v;
+		}
+		while (cursor < vertexCount)
+		{
+			if (liveCount[cursor] > 0)
+				return static_cast<int64_t>(cursor);
+			++cursor;
+		}
+		return -1;
+	};
+
+	int64_t fanning = nextFromDeadEnd();
+	clusters.push_back(0);
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (uint32_t k = offsets[fanning]; k < offsets[fanning + 1]; ++k)
+		{
+			uint32_t t = adjacency[k];
+			if (emitted[t])
+				continue;
+			emitted[t] = 1;
+			for (int c = 0; c < 3; ++c)
+			{
+				uint32_t v = indices[t * 3 + c];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--liveCount[v];
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+		}
+
+		// Prefer the candidate that will still be in the cache after its remaining fan.
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (liveCount[v] == 0)
+				continue;
+			int64_t priority = 0;
+			if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		if (best < 0)
+		{
+			// Dead end: the cache is effectively flushed, so start a new cluster here.
+			best = nextFromDeadEnd();
+			if (best >= 0 && output.size() != clusters.back())
+				clusters.push_back(static_cast<uint32_t>(output.size()));
+		}
+		fanning = best;
+	}
+
+	indices.swap(output);
+	return clusters;
+}
+
+void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &clusters)
+{
+	if (clusters.size() < 2 || vertices.empty())
+		return;
+
+	glm::vec3 meshCentroid(0.0f);
+	for (const Vertex &v : vertices)
+		meshCentroid += v.Position;
+	meshCentroid /= static_cast<float>(vertices.size());
+
+	// Occlusion potential: clusters facing away from the mesh centre are likely to occlude the rest.
+	struct Cluster
+	{
+		uint32_t begin, end;
+		float sortKey;
+	};
+	std::vector<Cluster> order(clusters.size());
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		uint32_t begin = clusters[c];
+		uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<uint32_t>(indices.size());
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (uint32_t i = begin; i + 2 < end; i += 3)
+		{
+			const glm::vec3 &a = vertices[indices[i]].Position;
+			const glm::vec3 &b = vertices[indices[i + 1]].Position;
+			const glm::vec3 &d = vertices[indices[i + 2]].Position;
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(n);
+			centroid += (a + b + d) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		if (area > 0.0f)
+			centroid /= area;
+		float normalLength = glm::length(normal);
+		if (normalLength > 0.0f)
+			normal /= normalLength;
+
+		order[c] = {begin, end, glm::dot(centroid - meshCentroid, normal)};
+	}
+
+	std::stable_sort(order.begin(), order.end(), [](const Cluster &a, const Cluster &b)
+					 { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (const Cluster &c : order)
+		output.insert(output.end(), indices.begin() + c.begin, indices.begin() + c.end);
+	indices.swap(output);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	const uint32_t unused = UINT32_MAX;
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<Vertex> output;
+	output.reserve(vertices.size());
+
+	for (uint32_t &index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(output);
+}
+
+float computeACMR(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned cacheSize)
+{
+	if (indices.size() < 3)
+		return 0.0f;
+
+	// FIFO cache simulated with insertion timestamps.
+	std::vector<uint32_t> insertedAt(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	size_t misses = 0;
+	for (uint32_t index : indices)
+	{
+		if (time - insertedAt[index] > cacheSize)
+		{
+			insertedAt[index] = time++;
+			++misses;
+		}
+	}
+	return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	std::vector<uint32_t> clusters = optimizeVertexCache(indices, vertices.size());
+	optimizeOverdraw(indices, vertices, clusters);
+	optimizeVertexFetch(vertices, indices);
+}
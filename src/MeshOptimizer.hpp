@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "assets.hpp"
+
+// Mesh preprocessing helpers that run once at load time (CPU only, no GL calls).
+
+// Merges bit-identical vertices of an unrolled triangle list. Writes the unique
+// vertices to out_vertices and one index per input vertex to out_indices.
+void weldVertices(const std::vector<Vertex> &vertices,
+                  std::vector<Vertex> &out_vertices,
+                  std::vector<uint32_t> &out_indices);
+
+// Returns true if every index fits into GL_UNSIGNED_SHORT.
+inline bool fitsShortIndices(size_t vertexCount) { return vertexCount <= 0x10000; }
+
+// Post-transform cache size assumed by the optimizer and the ACMR metric.
+constexpr unsigned kVertexCacheSize = 16;
+
+// Reorders triangles for post-transform vertex cache locality (Tipsify, Sander et al. 2007).
+// Returns the index offsets at which a new triangle cluster starts (always includes 0).
+std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount,
+                                          unsigned cacheSize = kVertexCacheSize);
+
+// Reorders the clusters returned by optimizeVertexCache so outward-facing ones are drawn
+// first, which lowers overdraw while keeping the in-cluster (cache friendly) order.
+void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                      const std::vector<uint32_t> &clusters);
+
+// Reorders vertices by first use in the index buffer and drops unreferenced ones.
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+// Average cache miss ratio: transformed vertices per triangle with a FIFO cache
+// (0.5 is the optimum for large regular grids, 3.0 the worst case).
+float computeACMR(const std::vector<uint32_t> &indices, size_t vertexCount,
+                  unsigned cacheSize = kVertexCacheSize);
+
+// Runs cache, overdraw and fetch optimization in order on an indexed triangle list.
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
@@ -1,100 +1,408 @@
+#include <cstdint>
+#include <cmath>
+#include <iostream>
 #include <string>
-#include <GL/glew.h> 
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "OBJloader.hpp"
+#include "MappedFile.hpp"
 
-#include <cstring>
-
-#define MAX_LINE_SIZE 255
+// The file is memory-mapped and scanned twice: a counting pass that sizes every
+// output exactly, then a parsing pass. Numbers are parsed by hand, so the result
+// does not depend on the C locale and no stdio calls are made per token.
 
-bool loadOBJ(const char * path, std::vector < glm::vec3 > & out_vertices, std::vector < glm::vec2 > & out_uvs, std::vector < glm::vec3 > & out_normals)
+namespace
 {
-	std::vector< unsigned int > vertexIndices, uvIndices, normalIndices;
-	std::vector< glm::vec3 > temp_vertices;
-	std::vector< glm::vec2 > temp_uvs;
-	std::vector< glm::vec3 > temp_normals;
+	// One face corner, as 0-based indices into the position/uv/normal arrays (-1 = absent).
+	struct Corner
+	{
+		int v, t, n;
+	};
+
+	inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+	inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+	inline const char *skipBlanks(const char *p, const char *end)
+	{
+		while (p < end && isBlank(*p))
+			++p;
+		return p;
+	}
+
+	// Returns the first character after the next newline.
+	inline const char *skipLine(const char *p, const char *end)
+	{
+		while (p < end && *p != '\n')
+			++p;
+		return p < end ? p + 1 : end;
+	}
+
+	// Returns true if the token at p ends (blank, newline, comment or end of input).
+	inline bool atTokenEnd(const char *p, const char *end)
+	{
+		return p >= end || isBlank(*p) || *p == '\n' || *p == '#';
+	}
+
+	// Parses a decimal float with optional sign, fraction and exponent.
+	bool parseFloat(const char *&p, const char *end, float &out)
+	{
+		static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+									   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+		p = skipBlanks(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			++p;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0;   // Significant digits stored in mantissa.
+		int exponent = 0; // Decimal exponent applied to mantissa.
+		bool any = false;
+
+		while (p < end && isDigit(*p))
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				if (mantissa != 0)
+					++digits;
+			}
+			else
+			{
+				++exponent;
+			}
+			++p;
+			any = true;
+		}
+
+		if (p < end && *p == '.')
+		{
+			++p;
+			while (p < end && isDigit(*p))
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+					if (mantissa != 0)
+						++digits;
+					--exponent;
+				}
+				++p;
+				any = true;
+			}
+		}
+
+		if (!any)
+			return false;
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char *q = p + 1;
+			bool negativeExp = false;
+			if (q < end && (*q == '-' || *q == '+'))
+			{
+				negativeExp = (*q == '-');
+				++q;
+			}
+			if (q < end && isDigit(*q))
+			{
+				int e = 0;
+				while (q < end && isDigit(*q))
+				{
+					if (e < 10000)
+						e = e * 10 + (*q - '0');
+					++q;
+				}
+				exponent += negativeExp ? -e : e;
+				p = q;
+			}
+		}
+
+		double value = static_cast<double>(mantissa);
+		if (exponent < 0)
+			value = (exponent >= -22) ? value / pow10[-exponent] : value * std::pow(10.0, exponent);
+		else if (exponent > 0)
+			value = (exponent <= 22) ? value * pow10[exponent] : value * std::pow(10.0, exponent);
+
+		out = static_cast<float>(negative ? -value : value);
+		return true;
+	}
+
+	// Parses a signed decimal integer.
+	bool parseInt(const char *&p, const char *end, long &out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			++p;
+		}
+		if (p >= end || !isDigit(*p))
+			return false;
+
+		long value = 0;
+		while (p < end && isDigit(*p))
+		{
+			value = value * 10 + (*p - '0');
+			++p;
+		}
+		out = negative ? -value : value;
+		return true;
+	}
+
+	// Converts a 1-based (or negative, relative) OBJ index into a 0-based one; -1 if invalid.
+	inline int resolveIndex(long raw, size_t count)
+	{
+		long idx = raw > 0 ? raw - 1 : static_cast<long>(count) + raw;
+		return (raw == 0 || idx < 0 || idx >= static_cast<long>(count)) ? -1 : static_cast<int>(idx);
+	}
+
+	enum class LineKind
+	{
+		Position,
+		TexCoord,
+		Normal,
+		Face,
+		Other
+	};
 
+	// Classifies the line at p (which must point past leading blanks) and advances p past the keyword.
+	inline LineKind classify(const char *&p, const char *end)
+	{
+		if (p + 1 >= end)
+			return LineKind::Other;
+		if (p[0] == 'v')
+		{
+			if (isBlank(p[1]))
+			{
+				p += 1;
+				return LineKind::Position;
+			}
+			if (p + 2 < end && isBlank(p[2]))
+			{
+				if (p[1] == 't')
+				{
+					p += 2;
+					return LineKind::TexCoord;
+				}
+				if (p[1] == 'n')
+				{
+					p += 2;
+					return LineKind::Normal;
+				}
+			}
+		}
+		else if (p[0] == 'f' && isBlank(p[1]))
+		{
+			p += 1;
+			return LineKind::Face;
+		}
+		return LineKind::Other;
+	}
+
+	// Counts the whitespace-separated tokens on a face line.
+	size_t countFaceTokens(const char *p, const char *end)
+	{
+		size_t tokens = 0;
+		while (true)
+		{
+			p = skipBlanks(p, end);
+			if (atTokenEnd(p, end))
+				break;
+			++tokens;
+			while (!atTokenEnd(p, end))
+				++p;
+		}
+		return tokens;
+	}
+
+	// Parses one "v", "v/t", "v//n" or "v/t/n" face token.
+	bool parseCorner(const char *&p, const char *end, size_t positions, size_t uvs, size_t normals, Corner &out)
+	{
+		long raw;
+		out.t = -1;
+		out.n = -1;
+
+		if (!parseInt(p, end, raw) || (out.v = resolveIndex(raw, positions)) < 0)
+			return false;
+
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+			{
+				if (!parseInt(p, end, raw) || (out.t = resolveIndex(raw, uvs)) < 0)
+					return false;
+			}
+			if (p < end && *p == '/')
+			{
+				++p;
+				if (!parseInt(p, end, raw) || (out.n = resolveIndex(raw, normals)) < 0)
+					return false;
+			}
+		}
+		return atTokenEnd(p, end);
+	}
+}
+
+bool loadOBJ(const char *path, std::vector<glm::vec3> &out_vertices, std::vector<glm::vec2> &out_uvs, std::vector<glm::vec3> &out_normals)
+{
 	out_vertices.clear();
 	out_uvs.clear();
 	out_normals.clear();
 
-	FILE * file;
-	//fopen_s(&file, path, "r"); // Windows
-	file = fopen(path, "r");
-	
-	if (file == NULL) {
-		printf("Impossible to open the file !\n");
+	MappedFile file;
+	if (!file.open(path))
+	{
+		std::cerr << "Error: Impossible to open the file: " << path << "\n";
 		return false;
 	}
 
-	while (1) {
+	const char *const begin = file.begin();
+	const char *const end = file.end();
 
-		char lineHeader[MAX_LINE_SIZE];
-		//int res = fscanf_s(file, "%s", lineHeader, MAX_LINE_SIZE); // Windows
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF) {
+	// Pass 1: count elements so every array is allocated exactly once.
+	size_t numPositions = 0, numUVs = 0, numNormals = 0, numCorners = 0;
+	for (const char *p = begin; p < end; p = skipLine(p, end))
+	{
+		p = skipBlanks(p, end);
+		switch (classify(p, end))
+		{
+		case LineKind::Position:
+			++numPositions;
+			break;
+		case LineKind::TexCoord:
+			++numUVs;
+			break;
+		case LineKind::Normal:
+			++numNormals;
+			break;
+		case LineKind::Face:
+		{
+			size_t tokens = countFaceTokens(p, end);
+			if (tokens >= 3)
+				numCorners += (tokens - 2) * 3; // Fan triangulation.
+			break;
+		}
+		default:
 			break;
 		}
+	}
+
+	std::vector<glm::vec3> temp_vertices;
+	std::vector<glm::vec2> temp_uvs;
+	std::vector<glm::vec3> temp_normals;
+	std::vector<Corner> corners;
+	temp_vertices.reserve(numPositions);
+	temp_uvs.reserve(numUVs);
+	temp_normals.reserve(numNormals);
+	corners.reserve(numCorners);
 
-		if (strcmp(lineHeader, "v") == 0) {
+	// Pass 2: parse.
+	std::vector<Corner> polygon;
+	size_t line = 0;
+	for (const char *p = begin; p < end; p = skipLine(p, end))
+	{
+		++line;
+		p = skipBlanks(p, end);
+		bool ok = true;
+		switch (classify(p, end))
+		{
+		case LineKind::Position:
+		{
 			glm::vec3 vertex;
-			//fscanf_s(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z); // Windows
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+			ok = parseFloat(p, end, vertex.x) && parseFloat(p, end, vertex.y) && parseFloat(p, end, vertex.z);
 			temp_vertices.push_back(vertex);
+			break;
 		}
-		else if (strcmp(lineHeader, "vt") == 0) {
-			glm::vec2 uv;
-			//fscanf_s(file, "%f %f\n", &uv.y, &uv.x); // Windows
-			fscanf(file, "%f %f\n", &uv.y, &uv.x);
+		case LineKind::TexCoord:
+		{
+			// Components are stored swapped (u in .y), matching the original fscanf loader. v is
+			// optional ("vt u") and defaults to 0.
+			glm::vec2 uv(0.0f);
+			ok = parseFloat(p, end, uv.y);
+			p = skipBlanks(p, end);
+			if (ok && !atTokenEnd(p, end))
+				ok = parseFloat(p, end, uv.x);
 			temp_uvs.push_back(uv);
+			break;
 		}
-		else if (strcmp(lineHeader, "vn") == 0) {
+		case LineKind::Normal:
+		{
 			glm::vec3 normal;
-			//fscanf_s(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z); // Windows
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+			ok = parseFloat(p, end, normal.x) && parseFloat(p, end, normal.y) && parseFloat(p, end, normal.z);
 			temp_normals.push_back(normal);
+			break;
 		}
-		else if (strcmp(lineHeader, "f") == 0) {
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			//int matches = fscanf_s(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]); // Windows
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-			if (matches != 9) {
-				printf("File can't be read by simple parser :( Try exporting with other options\n");
-				return false;
+		case LineKind::Face:
+		{
+			polygon.clear();
+			while (ok)
+			{
+				p = skipBlanks(p, end);
+				if (atTokenEnd(p, end))
+					break;
+				Corner c;
+				ok = parseCorner(p, end, temp_vertices.size(), temp_uvs.size(), temp_normals.size(), c);
+				polygon.push_back(c);
+			}
+			ok = ok && polygon.size() >= 3;
+			for (size_t i = 2; ok && i < polygon.size(); ++i)
+			{
+				corners.push_back(polygon[0]);
+				corners.push_back(polygon[i - 1]);
+				corners.push_back(polygon[i]);
 			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices.push_back(uvIndex[0]);
-			uvIndices.push_back(uvIndex[1]);
-			uvIndices.push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
+			break;
+		}
+		default:
+			break;
 		}
-	}
 
-	// unroll from indirect to direct vertex specification
-	// sometimes not necessary, definitely not optimal
+		if (!ok)
+		{
+			std::cerr << "Error: Malformed OBJ data at " << path << ":" << line << "\n";
+			return false;
+		}
+	}
 
-	for (unsigned int u = 0; u < vertexIndices.size(); u++) {
-		unsigned int vertexIndex = vertexIndices[u];
-		glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-		out_vertices.push_back(vertex);
+	// Corners without a normal get a smooth, area-weighted normal of their position.
+	std::vector<glm::vec3> smooth_normals;
+	for (size_t i = 0; i < corners.size(); i += 3)
+	{
+		if (corners[i].n >= 0 && corners[i + 1].n >= 0 && corners[i + 2].n >= 0)
+			continue;
+		if (smooth_normals.empty())
+			smooth_normals.assign(temp_vertices.size(), glm::vec3(0.0f));
+		const glm::vec3 &a = temp_vertices[corners[i].v];
+		const glm::vec3 &b = temp_vertices[corners[i + 1].v];
+		const glm::vec3 &c = temp_vertices[corners[i + 2].v];
+		glm::vec3 faceNormal = glm::cross(b - a, c - a);
+		for (size_t k = 0; k < 3; ++k)
+			smooth_normals[corners[i + k].v] += faceNormal;
 	}
-	for (unsigned int u = 0; u < uvIndices.size(); u++) {
-		unsigned int uvIndex = uvIndices[u];
-		glm::vec2 uv = temp_uvs[uvIndex - 1];
-		out_uvs.push_back(uv);
+	for (glm::vec3 &n : smooth_normals)
+	{
+		float len = glm::length(n);
+		n = len > 0.0f ? n / len : glm::vec3(0.0f, 1.0f, 0.0f);
 	}
-	for (unsigned int u = 0; u < normalIndices.size(); u++) {
-		unsigned int normalIndex = normalIndices[u];
-		glm::vec3 normal = temp_normals[normalIndex - 1];
-		out_normals.push_back(normal);
+
+	// Unroll from indexed to direct vertex specification.
+	out_vertices.resize(corners.size());
+	out_uvs.resize(corners.size());
+	out_normals.resize(corners.size());
+	for (size_t i = 0; i < corners.size(); ++i)
+	{
+		const Corner &c = corners[i];
+		out_vertices[i] = temp_vertices[c.v];
+		out_uvs[i] = c.t >= 0 ? temp_uvs[c.t] : glm::vec2(0.0f);
+		out_normals[i] = c.n >= 0 ? temp_normals[c.n] : smooth_normals[c.v];
 	}
 
-	fclose(file);
 	return true;
 }
@@ -5,6 +5,11 @@
 #include <vector>
 #include <glm/fwd.hpp>
 
+// Loads a Wavefront OBJ file as an unrolled triangle list (three entries per triangle
+// in every output array). Accepts "v", "v/t", "v//n" and "v/t/n" corners, polygons
+// (fan-triangulated) and negative (relative) indices. Missing texture coordinates
+// become (0,0) and a "vt" line with only u gets v = 0; missing normals are replaced by
+// smooth area-weighted vertex normals.
 bool loadOBJ(
 	const char * path,
 	std::vector < glm::vec3 > & out_vertices,
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "OITBuffer.hpp"
+
+void OITBuffer::create(int newWidth, int newHeight)
+{
+	clear();
+	width = newWidth;
+	height = newHeight;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &accumTexture);
+	glTextureStorage2D(accumTexture, 1, GL_RGBA16F, width, height);
+	glCreateTextures(GL_TEXTURE_2D, 1, &revealageTexture);
+	glTextureStorage2D(revealageTexture, 1, GL_R8, width, height);
+	for (GLuint texture : {accumTexture, revealageTexture})
+	{
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	// Same format as the default framebuffer's depth (24 + 8 stencil), as the blit requires.
+	glCreateRenderbuffers(1, &depthBuffer);
+	glNamedRenderbufferStorage(depthBuffer, GL_DEPTH24_STENCIL8, width, height);
+
+	glCreateFramebuffers(1, &framebuffer);
+	glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, accumTexture, 0);
+	glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, revealageTexture, 0);
+	glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glNamedFramebufferDrawBuffers(framebuffer, 2, drawBuffers);
+	if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Error: Transparency framebuffer is incomplete\n";
+		throw std::runtime_error("OIT framebuffer creation failed");
+	}
+
+	glCreateVertexArrays(1, &emptyVAO);
+}
+
+void OITBuffer::begin(int newWidth, int newHeight)
+{
+	if (framebuffer == 0 || newWidth != width || newHeight != height)
+		create(newWidth, newHeight);
+
+	// Transparent fragments must still be hidden by opaque geometry.
+	glBlitNamedFramebuffer(0, framebuffer, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	const GLfloat noAccum[] = {0.0f, 0.0f, 0.0f, 0.0f};
+	const GLfloat fullyRevealed[] = {1.0f, 0.0f, 0.0f, 0.0f};
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, noAccum);
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 1, fullyRevealed);
+
+	// accum += color * weight; revealage *= 1 - alpha.
+	glBlendFunci(0, GL_ONE, GL_ONE);
+	glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+void OITBuffer::composite()
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_DEPTH_TEST);
+
+	compositeProgram.activate();
+	glBindTextureUnit(0, accumTexture);
+	glBindTextureUnit(1, revealageTexture);
+	glBindVertexArray(emptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glEnable(GL_DEPTH_TEST);
+}
+
+void OITBuffer::clear()
+{
+	if (framebuffer != 0)
+		glDeleteFramebuffers(1, &framebuffer);
+	if (accumTexture != 0)
+		glDeleteTextures(1, &accumTexture);
+	if (revealageTexture != 0)
+		glDeleteTextures(1, &revealageTexture);
+	if (depthBuffer != 0)
+		glDeleteRenderbuffers(1, &depthBuffer);
+	if (emptyVAO != 0)
+		glDeleteVertexArrays(1, &emptyVAO);
+	framebuffer = accumTexture = revealageTexture = depthBuffer = emptyVAO = 0;
+	width = height = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "ShaderProgram.hpp"
+
+// Weighted blended order-independent transparency (McGuire and Bavoil, 2013).
+//
+// Transparent surfaces are drawn in any order into two targets while depth testing against the
+// opaque scene: accum (RGBA16F) sums premultiplied color and alpha scaled by a depth weight,
+// revealage (R8) multiplies (1 - alpha) down from 1. composite() then blends
+// accum.rgb / accum.a over the default framebuffer with coverage 1 - revealage. basic.frag
+// writes both targets when uWeightedOIT is set.
+//
+// The targets are single-sampled; the scene depth is copied (resolved) into them from the default
+// framebuffer before the transparent draws, so transparent edges are not antialiased.
+class OITBuffer
+{
+public:
+    OITBuffer() = default;
+    OITBuffer(const OITBuffer &) = delete;
+    OITBuffer &operator=(const OITBuffer &) = delete;
+    ~OITBuffer() { clear(); }
+
+    // Full-screen program of the resolve step (oit_composite.vert / oit_composite.frag).
+    void setCompositeProgram(const ShaderProgram &program) { compositeProgram = program; }
+    bool ready() const { return compositeProgram.getID() != 0; }
+
+    // Binds the targets (resized to width x height), copies the scene depth into them, clears
+    // them and sets the accumulation blend functions. Blending itself is left to the caller.
+    void begin(int width, int height);
+
+    // Back to the default framebuffer: blends the transparent layer over the opaque scene and
+    // restores the default blend function.
+    void composite();
+
+    // Releases the targets (call while the GL context is alive).
+    void clear();
+
+private:
+    GLuint framebuffer = 0;
+    GLuint accumTexture = 0;
+    GLuint revealageTexture = 0;
+    GLuint depthBuffer = 0;
+    GLuint emptyVAO = 0; // The composite triangle comes from gl_VertexID.
+    int width = 0, height = 0;
+    ShaderProgram compositeProgram;
+
+    void create(int width, int height);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Number of worker threads used when a caller passes threads <= 0.
+inline int defaultThreadCount()
+{
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+// Calls body(begin, end) on contiguous, disjoint slices of [0, count), one slice per thread; the
+// calling thread runs the first slice and waits for the rest. Slices hold at least minPerThread
+// items, so small jobs stay on the calling thread. Each item must be independent of the others,
+// which makes the result the same for any thread count.
+template <typename Body>
+void parallelFor(size_t count, Body &&body, int threads = 0, size_t minPerThread = 1)
+{
+    if (count == 0)
+        return;
+    size_t workers = static_cast<size_t>(threads > 0 ? threads : defaultThreadCount());
+    workers = std::clamp<size_t>(count / std::max<size_t>(minPerThread, 1), 1, workers);
+    if (workers == 1)
+    {
+        body(size_t(0), count);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    auto slice = [&](size_t w)
+    { return count * w / workers; };
+    for (size_t w = 1; w < workers; ++w)
+        pool.emplace_back([&body, begin = slice(w), end = slice(w + 1)]
+                          { body(begin, end); });
+    body(size_t(0), slice(1));
+    for (std::thread &thread : pool)
+        thread.join();
+}
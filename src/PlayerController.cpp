@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "PlayerController.hpp"
+
+bool PlayerController::sweep(const AABB &box, const glm::vec3 &delta, const AABB &obstacle, SweepHit &hit)
+{
+	// Slab test: the time interval in which the boxes overlap on each axis, intersected.
+	float entry = -INFINITY, exit = INFINITY;
+	int entryAxis = -1;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (delta[axis] == 0.0f)
+		{
+			// No motion on this axis: the boxes must already overlap on it (strictly).
+			if (box.max[axis] <= obstacle.min[axis] || box.min[axis] >= obstacle.max[axis])
+				return false;
+			continue;
+		}
+		float inv = 1.0f / delta[axis];
+		float t0 = (obstacle.min[axis] - box.max[axis]) * inv;
+		float t1 = (obstacle.max[axis] - box.min[axis]) * inv;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > entry)
+		{
+			entry = t0;
+			entryAxis = axis;
+		}
+		exit = std::min(exit, t1);
+	}
+
+	// No motion, separating, out of reach this step, or already penetrating.
+	if (entryAxis < 0 || entry > exit || entry >= 1.0f || exit <= 0.0f || entry < 0.0f)
+		return false;
+
+	hit.time = entry;
+	hit.normal = glm::vec3(0.0f);
+	hit.normal[entryAxis] = delta[entryAxis] > 0.0f ? -1.0f : 1.0f;
+	return true;
+}
+
+void PlayerController::step(State &state, const Input &input, float dt, const CollisionGrid &grid)
+{
+	if (input.jump && state.grounded)
+		state.velocity.y = jumpSpeed;
+
+	// Constant-acceleration motion integrated exactly, so the fall does not depend on the step length.
+	float startVelocityY = state.velocity.y;
+	state.velocity.x = input.wishVelocity.x;
+	state.velocity.z = input.wishVelocity.z;
+	state.velocity.y += gravity * dt;
+	glm::vec3 delta(input.wishVelocity.x * dt, startVelocityY * dt + 0.5f * gravity * dt * dt, input.wishVelocity.z * dt);
+	state.grounded = false;
+
+	// Sliding never grows a component of the motion, so the first swept region covers every slide.
+	AABB start{state.position + boxMin, state.position + boxMax};
+	AABB region{glm::min(start.min, start.min + delta), glm::max(start.max, start.max + delta)};
+	candidates.clear();
+	grid.gather(region, candidates);
+
+	for (int slide = 0; slide < kMaxSlides && delta != glm::vec3(0.0f); ++slide)
+	{
+		AABB box{state.position + boxMin, state.position + boxMax};
+		SweepHit first;
+		bool collided = false;
+		for (const AABB &candidate : candidates)
+		{
+			SweepHit hit;
+			if (sweep(box, delta, candidate, hit) && hit.time < first.time)
+			{
+				first = hit;
+				collided = true;
+			}
+		}
+
+		if (!collided)
+		{
+			state.position += delta;
+			break;
+		}
+
+		// Move to the contact, then slide the rest of the motion along the surface.
+		state.position += delta * first.time + first.normal * kSkin;
+		glm::vec3 remaining = delta * (1.0f - first.time);
+		delta = remaining - first.normal * glm::dot(remaining, first.normal);
+
+		float intoSurface = glm::dot(state.velocity, first.normal);
+		if (intoSurface < 0.0f)
+			state.velocity -= first.normal * intoSurface;
+		if (first.normal.y > 0.5f)
+			state.grounded = true;
+	}
+
+	// Floors are height fields rather than boxes: clamp to the surface.
+	float floorY;
+	if (floorHeight && floorHeight(state.position, floorY) && state.position.y - floorOffset <= floorY)
+	{
+		state.position.y = floorY + floorOffset;
+		state.velocity.y = 0.0f;
+		state.grounded = true;
+	}
+}
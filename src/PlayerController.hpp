@@ -0,0 +1,64 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "CollisionGrid.hpp"
+
+// Result of sweeping a moving box against a static one.
+struct SweepHit
+{
+    float time = 1.0f;           // Fraction of the motion before contact, in [0, 1].
+    glm::vec3 normal{0.0f};      // Contact normal, pointing from the obstacle toward the mover.
+};
+
+// Continuous player movement against the collision grid. No window or GL state is involved,
+// so the controller can be driven headlessly from recorded input (see tools/player_replay.cpp).
+//
+// Each step integrates gravity exactly for the step length, sweeps the player box along the
+// whole displacement, stops at the earliest time of impact, removes the velocity component
+// into the contact normal and slides along the remainder. Because nothing is sampled at
+// discrete positions, a large step cannot tunnel through a wall or a box top.
+class PlayerController
+{
+public:
+    struct State
+    {
+        glm::vec3 position{0.0f};
+        glm::vec3 velocity{0.0f}; // Only y persists between steps; x/z come from the input.
+        bool grounded = false;
+    };
+
+    struct Input
+    {
+        glm::vec3 wishVelocity{0.0f}; // Horizontal velocity requested by the player.
+        bool jump = false;
+    };
+
+    // Player box relative to the eye position (the box extends further down than up).
+    glm::vec3 boxMin{-0.2f, -0.4f, -0.2f};
+    glm::vec3 boxMax{0.2f, 0.2f, 0.2f};
+
+    float gravity = -9.81f;
+    float jumpSpeed = 5.0f;
+    float floorOffset = 0.1f; // Eye height kept above the floor surface.
+
+    // Floor height below a position (flat floors and heightmaps); returns false outside every floor.
+    std::function<bool(const glm::vec3 &position, float &floorHeight)> floorHeight;
+
+    // Advances the state by dt seconds.
+    void step(State &state, const Input &input, float dt, const CollisionGrid &grid);
+
+    // Sweeps box by delta against obstacle. Returns true and fills hit on contact within the motion;
+    // boxes that already overlap at the start are ignored so a penetrating player can always leave.
+    static bool sweep(const AABB &box, const glm::vec3 &delta, const AABB &obstacle, SweepHit &hit);
+
+private:
+    static constexpr int kMaxSlides = 4;
+    static constexpr float kSkin = 1e-4f; // Gap left between the player and a contact.
+
+    std::vector<AABB> candidates;
+};
@@ -0,0 +1,379 @@
+#include <cstring>
+
+#include "RenderQueue.hpp"
+#include "FrameProfiler.hpp"
+#include "UniformBlocks.hpp"
+
+void RenderQueue::begin(const glm::vec3 &eyePosition)
+{
+	eye = eyePosition;
+	packets.clear();
+}
+
+void RenderQueue::submit(Model &model, Pass pass)
+{
+	const std::vector<glm::mat4> &matrices = model.getMeshMatrices();
+	for (size_t m = 0; m < model.meshes.size(); ++m)
+	{
+		const Mesh &mesh = model.meshes[m];
+		if (!mesh.geometry)
+			continue;
+		packets.push_back({&mesh, matrices[m], mesh.getMaterialIndex(), pass});
+	}
+}
+
+uint64_t RenderQueue::makeKey(const Packet &packet, float distanceSq, bool sortTransparent)
+{
+	// Non-negative IEEE floats order like their bit patterns; keep the top 24 bits.
+	uint32_t distanceBits;
+	std::memcpy(&distanceBits, &distanceSq, sizeof(distanceBits));
+	uint64_t depth = distanceBits >> 8;
+
+	// GL names are small integers; truncation only costs sort quality, never correctness,
+	// because submission compares the real state.
+	const Mesh &mesh = *packet.mesh;
+	uint64_t program = mesh.shader.getID() & 0x1FFu;
+	uint64_t texture = textureBinding(packet) & 0x3FFFu;
+	uint64_t vao = mesh.geometry->VAO & 0xFFFFu;
+	uint64_t state = (program << 30) | (texture << 16) | vao;
+
+	if (packet.pass == OPAQUE_PASS || !sortTransparent)
+		return (uint64_t(packet.pass) << 63) | (state << 24) | depth;
+	return (uint64_t(TRANSPARENT_PASS) << 63) | ((~depth & 0xFFFFFFu) << 39) | state;
+}
+
+GLuint RenderQueue::textureBinding(const Packet &packet)
+{
+	return packet.mesh->texture ? packet.mesh->texture->binding() : 0;
+}
+
+bool RenderQueue::sameState(const Packet &a, const Packet &b)
+{
+	return a.pass == b.pass && a.material == b.material &&
+		   a.mesh->geometry == b.mesh->geometry && textureBinding(a) == textureBinding(b) &&
+		   a.mesh->shader.getID() == b.mesh->shader.getID() && a.mesh->primitive_type == b.mesh->primitive_type;
+}
+
+void RenderQueue::radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch)
+{
+	// LSD radix sort, 8 bits per pass; passes where every key has the same digit are skipped.
+	scratch.resize(items.size());
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (const SortItem &item : items)
+			++histogram[(item.key >> shift) & 0xFF];
+		if (histogram[(items.front().key >> shift) & 0xFF] == items.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t &bucket : histogram)
+		{
+			size_t count = bucket;
+			bucket = offset;
+			offset += count;
+		}
+		for (const SortItem &item : items)
+			scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+		items.swap(scratch);
+	}
+}
+
+void RenderQueue::upload()
+{
+	if (instanceBuffer == 0)
+	{
+		glCreateBuffers(1, &instanceBuffer);
+		glCreateBuffers(1, &layerBuffer);
+	}
+	if (staging.size() > bufferCapacity)
+	{
+		bufferCapacity = staging.size() + staging.size() / 2;
+		glNamedBufferData(instanceBuffer, bufferCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+		glNamedBufferData(layerBuffer, bufferCapacity * sizeof(GLint), nullptr, GL_STREAM_DRAW);
+	}
+	else
+	{
+		// Orphan the previous frame's storage so the upload never waits for the GPU.
+		glInvalidateBufferData(instanceBuffer);
+		glInvalidateBufferData(layerBuffer);
+	}
+	glNamedBufferSubData(instanceBuffer, 0, staging.size() * sizeof(glm::mat4), staging.data());
+	glNamedBufferSubData(layerBuffer, 0, stagingLayers.size() * sizeof(GLint), stagingLayers.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding, instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceLayerBinding, layerBuffer);
+}
+
+void RenderQueue::setDepthProgram(const ShaderProgram &program)
+{
+	depthProgram = program;
+	// The pre-pass only ever draws instanced.
+	depthProgram.setUniform(depthProgram.uniform("uInstanced"), true);
+}
+
+void RenderQueue::readQueries()
+{
+	queryFrame = (queryFrame + 1) % kQueryFrames;
+	for (int pass = 0; pass < QUERY_PASSES; ++pass)
+	{
+		if (!queryPending[queryFrame][pass])
+			continue;
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(queries[queryFrame][pass], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+			glGetQueryObjectui64v(queries[queryFrame][pass], GL_QUERY_RESULT, &fragmentCounts[pass]);
+		queryPending[queryFrame][pass] = false; // A late result is dropped rather than waited for.
+	}
+	lastStats.depthFragments = fragmentCounts[DEPTH_QUERY];
+	lastStats.opaqueFragments = fragmentCounts[OPAQUE_QUERY];
+	lastStats.transparentFragments = fragmentCounts[TRANSPARENT_QUERY];
+}
+
+void RenderQueue::beginQuery(QueryPass pass)
+{
+	if (!GLEW_ARB_pipeline_statistics_query && !GLEW_VERSION_4_6)
+		return;
+	GLuint &query = queries[queryFrame][pass];
+	if (query == 0)
+		glCreateQueries(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, 1, &query);
+	glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, query);
+	queryPending[queryFrame][pass] = true;
+}
+
+void RenderQueue::endQuery(QueryPass pass)
+{
+	if (queryPending[queryFrame][pass])
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+}
+
+void RenderQueue::drawDepth(size_t opaqueGroups)
+{
+	// Same groups, instances and matrices as the shading pass, positions only, no color.
+	beginQuery(DEPTH_QUERY);
+	depthProgram.activate();
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	GLuint currentVAO = 0;
+	for (size_t g = 0; g < opaqueGroups; ++g)
+	{
+		const DrawGroup &group = groups[g];
+		const Mesh &mesh = *packets[items[group.first].packet].mesh;
+		if (mesh.geometry->depthVAO != currentVAO)
+		{
+			currentVAO = mesh.geometry->depthVAO;
+			glBindVertexArray(currentVAO);
+		}
+		mesh.drawInstanced(static_cast<GLsizei>(group.count), group.baseInstance);
+		++lastStats.depthDraws;
+	}
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	endQuery(DEPTH_QUERY);
+
+	// Only the nearest surface of each pixel passes now; the depth buffer is already final.
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+}
+
+void RenderQueue::flush()
+{
+	lastStats = Stats();
+	lastStats.packets = packets.size();
+	readQueries();
+	if (packets.empty())
+		return;
+
+	// Build and sort the keys.
+	PG2_PROFILE_BEGIN_OPTIONAL(profiler, FrameProfiler::SORT_PHASE);
+	const bool useOIT = transparency == WEIGHTED_BLENDED_OIT && oit.ready();
+	items.resize(packets.size());
+	for (size_t i = 0; i < packets.size(); ++i)
+	{
+		glm::vec3 delta = glm::vec3(packets[i].matrix[3]) - eye;
+		items[i] = {makeKey(packets[i], glm::dot(delta, delta), !useOIT), static_cast<uint32_t>(i)};
+	}
+	radixSort(items, scratch);
+
+	// Merge runs with identical state and lay out their matrices contiguously.
+	groups.clear();
+	staging.clear();
+	stagingLayers.clear();
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const Packet &packet = packets[items[i].packet];
+		if (groups.empty() || !sameState(packets[items[groups.back().first].packet], packet))
+			groups.push_back({static_cast<uint32_t>(i), 0, static_cast<GLuint>(staging.size())});
+		++groups.back().count;
+		staging.push_back(packet.matrix);
+		stagingLayers.push_back(packet.mesh->texture ? packet.mesh->texture->layer : -1);
+	}
+	upload();
+	PG2_PROFILE_END_OPTIONAL(profiler, FrameProfiler::SORT_PHASE);
+
+	// Opaque groups sort first.
+	size_t opaqueGroups = 0;
+	while (opaqueGroups < groups.size() && packets[items[groups[opaqueGroups].first].packet].pass == OPAQUE_PASS)
+		++opaqueGroups;
+	const bool prepass = depthPrepassEnabled && depthProgram.getID() != 0 && opaqueGroups > 0;
+	PG2_PROFILE_BEGIN_OPTIONAL(profiler, FrameProfiler::OPAQUE_PHASE);
+	if (prepass)
+		drawDepth(opaqueGroups);
+
+	// Submit, binding only what changed since the previous group.
+	GLuint currentProgram = 0, currentTexture = 0, currentVAO = 0, currentMaterial = ~0u;
+	bool blending = false;
+	beginQuery(OPAQUE_QUERY);
+	std::vector<const Mesh *> programsUsed;
+	size_t naiveBinds = 0;
+	for (const DrawGroup &group : groups)
+	{
+		const Packet &packet = packets[items[group.first].packet];
+		const Mesh &mesh = *packet.mesh;
+
+		if (packet.pass == TRANSPARENT_PASS && !blending)
+		{
+			endQuery(OPAQUE_QUERY);
+			PG2_PROFILE_END_OPTIONAL(profiler, FrameProfiler::OPAQUE_PHASE);
+			PG2_PROFILE_BEGIN_OPTIONAL(profiler, FrameProfiler::TRANSPARENT_PHASE);
+			beginQuery(TRANSPARENT_QUERY);
+			if (prepass)
+				glDepthFunc(GL_LESS);
+			if (useOIT)
+			{
+				GLint viewport[4];
+				glGetIntegerv(GL_VIEWPORT, viewport);
+				oit.begin(viewport[0] + viewport[2], viewport[1] + viewport[3]);
+				currentProgram = 0; // Re-activate to switch uWeightedOIT on.
+			}
+			glEnable(GL_BLEND);
+			glDepthMask(GL_FALSE);
+			blending = true;
+		}
+
+		if (mesh.shader.getID() != currentProgram)
+		{
+			currentProgram = mesh.shader.getID();
+			mesh.shader.activate();
+			mesh.shader.setUniform(mesh.uniforms.sampler, static_cast<int>(kTextureUnit));
+			mesh.shader.setUniform(mesh.uniforms.instanced, true);
+			mesh.shader.setUniform(mesh.uniforms.weightedOIT, blending && useOIT);
+			programsUsed.push_back(&mesh);
+			++lastStats.programBinds;
+		}
+		if (packet.material != currentMaterial)
+		{
+			currentMaterial = packet.material;
+			MaterialBuffer::instance().bind(currentMaterial);
+			++lastStats.materialBinds;
+		}
+		if (mesh.texture && mesh.texture->binding() != currentTexture)
+		{
+			currentTexture = mesh.texture->binding();
+			mesh.texture->bind();
+			++lastStats.textureBinds;
+		}
+		if (mesh.geometry->VAO != currentVAO)
+		{
+			currentVAO = mesh.geometry->VAO;
+			glBindVertexArray(currentVAO);
+			++lastStats.vaoBinds;
+		}
+
+		mesh.drawInstanced(static_cast<GLsizei>(group.count), group.baseInstance);
+		++lastStats.draws;
+		naiveBinds += group.count * (mesh.texture ? 4 : 3); // program, material, VAO (+ texture) per mesh
+	}
+
+	if (blending)
+	{
+		endQuery(TRANSPARENT_QUERY);
+		if (useOIT)
+			oit.composite();
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		PG2_PROFILE_END_OPTIONAL(profiler, FrameProfiler::TRANSPARENT_PHASE);
+	}
+	else
+	{
+		endQuery(OPAQUE_QUERY);
+		if (prepass)
+		{
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_TRUE);
+		}
+		PG2_PROFILE_END_OPTIONAL(profiler, FrameProfiler::OPAQUE_PHASE);
+	}
+	for (const Mesh *mesh : programsUsed)
+	{
+		mesh->shader.setUniform(mesh->uniforms.instanced, false);
+		mesh->shader.setUniform(mesh->uniforms.weightedOIT, false);
+	}
+
+	size_t issued = lastStats.programBinds + lastStats.materialBinds + lastStats.textureBinds + lastStats.vaoBinds;
+	lastStats.bindsSaved = naiveBinds - issued;
+}
+
+void RenderQueue::flushDepth(const ShaderProgram &program)
+{
+	lastStats = Stats();
+	lastStats.packets = packets.size();
+	if (packets.empty())
+		return;
+
+	// Only the geometry matters: sort by it, so every mesh shape becomes one instanced draw.
+	items.resize(packets.size());
+	for (size_t i = 0; i < packets.size(); ++i)
+		items[i] = {static_cast<uint64_t>(packets[i].mesh->geometry->depthVAO), static_cast<uint32_t>(i)};
+	radixSort(items, scratch);
+
+	groups.clear();
+	staging.clear();
+	stagingLayers.clear();
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const Packet &packet = packets[items[i].packet];
+		if (groups.empty() || packets[items[groups.back().first].packet].mesh->geometry != packet.mesh->geometry ||
+			packets[items[groups.back().first].packet].mesh->primitive_type != packet.mesh->primitive_type)
+			groups.push_back({static_cast<uint32_t>(i), 0, static_cast<GLuint>(staging.size())});
+		++groups.back().count;
+		staging.push_back(packet.matrix);
+		stagingLayers.push_back(-1);
+	}
+	upload();
+
+	program.activate();
+	for (const DrawGroup &group : groups)
+	{
+		const Mesh &mesh = *packets[items[group.first].packet].mesh;
+		glBindVertexArray(mesh.geometry->depthVAO);
+		++lastStats.vaoBinds;
+		mesh.drawInstanced(static_cast<GLsizei>(group.count), group.baseInstance);
+		++lastStats.depthDraws;
+	}
+}
+
+void RenderQueue::clear()
+{
+	if (instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &instanceBuffer);
+		glDeleteBuffers(1, &layerBuffer);
+		instanceBuffer = layerBuffer = 0;
+	}
+	bufferCapacity = 0;
+	oit.clear();
+	for (int frame = 0; frame < kQueryFrames; ++frame)
+	{
+		for (int pass = 0; pass < QUERY_PASSES; ++pass)
+		{
+			if (queries[frame][pass] != 0)
+				glDeleteQueries(1, &queries[frame][pass]);
+			queries[frame][pass] = 0;
+			queryPending[frame][pass] = false;
+		}
+	}
+	packets.clear();
+	items.clear();
+	scratch.clear();
+	groups.clear();
+	staging.clear();
+	stagingLayers.clear();
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Model.hpp"
+#include "OITBuffer.hpp"
+
+class FrameProfiler;
+
+// Collects draw packets for a frame, sorts them by a 64-bit key and submits them with
+// redundant-state filtering. Consecutive packets that share all state are merged into one
+// glDrawElementsInstancedBaseInstance call; their model matrices come from a shader storage
+// buffer that basic.vert reads as instanceModel[gl_BaseInstance + gl_InstanceID]. Textures
+// packed into an array (AssetManager::packTextures) count as one texture state: their layers
+// go to the shader per instance, so meshes that differ only in which layer they sample merge
+// into one draw and never rebind a texture.
+//
+// Transparent packets are either resolved with weighted blended OIT (OITBuffer), which needs no
+// order, so they sort and merge by state exactly like opaque ones; or, in the sorted fallback,
+// drawn back-to-front with ordinary alpha blending (wrong where transparent meshes intersect).
+//
+// Key layout (most significant bit first):
+//   opaque, OIT: pass(1) | program(9) | texture(14) | VAO(16) | depth(24), depth front-to-back
+//   sorted:      pass(1) | depth(24), back-to-front | program(9) | texture(14) | VAO(16)
+// where texture is the bound object: the array for packed textures.
+//
+// With the depth pre-pass enabled, the opaque packets are first drawn into the depth buffer
+// alone (depth.vert over each geometry's position-only VAO, no color writes); the shading pass
+// then runs with GL_EQUAL and no depth writes, so basic.frag runs once per visible pixel instead
+// of once per overlapping surface. Fragment shader invocations of each pass are counted with
+// pipeline statistics queries when the driver has them.
+class RenderQueue
+{
+public:
+    enum Pass : uint8_t
+    {
+        OPAQUE_PASS = 0,     // Depth write on, sorted by state then front-to-back.
+        TRANSPARENT_PASS = 1 // Blended, depth write off, OIT or sorted back-to-front.
+    };
+
+    enum Transparency : uint8_t
+    {
+        SORTED_TRANSPARENCY = 0, // Back-to-front alpha blending.
+        WEIGHTED_BLENDED_OIT = 1 // Any order, resolved by OITBuffer.
+    };
+
+    // Binding points of the InstanceMatrices and InstanceLayers blocks in basic.vert.
+    static constexpr GLuint kInstanceBinding = 0;
+    static constexpr GLuint kInstanceLayerBinding = 1;
+
+    // Per-frame statistics of the last flush().
+    struct Stats
+    {
+        size_t packets = 0;       // Meshes submitted.
+        size_t draws = 0;         // Draw calls issued after merging.
+        size_t programBinds = 0;  // glUseProgram calls issued.
+        size_t textureBinds = 0;  // Texture binds issued.
+        size_t vaoBinds = 0;      // VAO binds issued.
+        size_t materialBinds = 0; // Material block binds issued.
+        size_t bindsSaved = 0;    // Binds a per-mesh draw would have issued minus the above.
+        size_t depthDraws = 0;    // Draw calls of the depth pre-pass.
+
+        // Fragment shader invocations per pass, from the newest finished frame (0 without
+        // ARB_pipeline_statistics_query / GL 4.6).
+        uint64_t depthFragments = 0;
+        uint64_t opaqueFragments = 0;
+        uint64_t transparentFragments = 0;
+    };
+
+    RenderQueue() = default;
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+    ~RenderQueue() { clear(); }
+
+    // Starts a new frame; depth keys are measured from eye.
+    void begin(const glm::vec3 &eye);
+
+    // Queues every mesh of the model in the given pass.
+    void submit(Model &model, Pass pass);
+
+    // Sorts the packets, uploads the matrices and issues the draws.
+    void flush();
+
+    // Draws every queued packet into the depth buffer only, grouped by geometry alone, with
+    // program reading InstanceMatrices over the position-only VAOs (shadow maps). Pass,
+    // material and texture are ignored; the caller sets up the target and depth state.
+    void flushDepth(const ShaderProgram &program);
+
+    // Releases the instance buffer and queries (call while the GL context is alive).
+    void clear();
+
+    // Program of the depth pre-pass (depth.vert / depth.frag); the pre-pass needs one to run.
+    void setDepthProgram(const ShaderProgram &program);
+    void setDepthPrepass(bool enabled) { depthPrepassEnabled = enabled; }
+    bool depthPrepass() const { return depthPrepassEnabled; }
+
+    // Program of the OIT composite (oit_composite.vert / .frag); OIT falls back to sorting without one.
+    void setCompositeProgram(const ShaderProgram &program) { oit.setCompositeProgram(program); }
+    void setTransparency(Transparency mode) { transparency = mode; }
+    Transparency transparencyMode() const { return transparency; }
+
+    // Times flush()'s sort, opaque and transparent phases (none if null or compiled out).
+    void setProfiler(FrameProfiler *newProfiler) { profiler = newProfiler; }
+
+    const Stats &stats() const { return lastStats; }
+
+private:
+    struct Packet
+    {
+        const Mesh *mesh;
+        glm::mat4 matrix;
+        GLuint material; // MaterialBuffer entry.
+        Pass pass;
+    };
+
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    // A run of sorted packets drawn with one instanced call.
+    struct DrawGroup
+    {
+        uint32_t first; // First SortItem of the run.
+        uint32_t count;
+        GLuint baseInstance;
+    };
+
+    glm::vec3 eye{0.0f};
+    std::vector<Packet> packets;
+    std::vector<SortItem> items;
+    std::vector<SortItem> scratch;
+    std::vector<DrawGroup> groups;
+    std::vector<glm::mat4> staging;
+    std::vector<GLint> stagingLayers; // Texture array layer per instance, -1 for 2D textures.
+
+    GLuint instanceBuffer = 0;
+    GLuint layerBuffer = 0;
+    size_t bufferCapacity = 0; // In instances.
+
+    ShaderProgram depthProgram;
+    bool depthPrepassEnabled = false;
+
+    OITBuffer oit;
+    Transparency transparency = WEIGHTED_BLENDED_OIT;
+
+    FrameProfiler *profiler = nullptr;
+
+    // Fragment invocation queries per pass, double-buffered so results are read a frame late
+    // without stalling.
+    enum QueryPass
+    {
+        DEPTH_QUERY,
+        OPAQUE_QUERY,
+        TRANSPARENT_QUERY,
+        QUERY_PASSES
+    };
+    static constexpr int kQueryFrames = 2;
+    GLuint queries[kQueryFrames][QUERY_PASSES] = {};
+    bool queryPending[kQueryFrames][QUERY_PASSES] = {};
+    int queryFrame = 0;
+    uint64_t fragmentCounts[QUERY_PASSES] = {};
+
+    Stats lastStats;
+
+    static uint64_t makeKey(const Packet &packet, float distanceSq, bool sortTransparent);
+    static GLuint textureBinding(const Packet &packet);
+    static bool sameState(const Packet &a, const Packet &b);
+    static void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch);
+    void upload();
+    void readQueries();
+    void beginQuery(QueryPass pass);
+    void endQuery(QueryPass pass);
+    void drawDepth(size_t opaqueGroups);
+};
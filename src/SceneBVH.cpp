@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PG2_SSE 1
+#endif
+
+#include "SceneBVH.hpp"
+
+Frustum::Frustum(const glm::mat4 &m)
+{
+	// Rows of the matrix (glm is column-major).
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	const glm::vec4 planes[6] = {
+		row3 + row0, // Left.
+		row3 - row0, // Right.
+		row3 + row1, // Bottom.
+		row3 - row1, // Top.
+		row3 + row2, // Near.
+		row3 - row2	 // Far.
+	};
+
+	for (int i = 0; i < 8; ++i)
+	{
+		glm::vec4 plane = i < 6 ? planes[i] / glm::length(glm::vec3(planes[i])) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		nx[i] = plane.x;
+		ny[i] = plane.y;
+		nz[i] = plane.z;
+		d[i] = plane.w;
+		ax[i] = std::abs(plane.x);
+		ay[i] = std::abs(plane.y);
+		az[i] = std::abs(plane.z);
+	}
+}
+
+Frustum::Result Frustum::test(const AABB &box) const
+{
+	glm::vec3 c = box.center();
+	glm::vec3 e = box.extents();
+
+#ifdef PG2_SSE
+	const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+	const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+	const __m128 zero = _mm_setzero_ps();
+	int outside = 0, straddle = 0;
+	for (int i = 0; i < 8; i += 4)
+	{
+		// Signed distance of the center and projected radius of the box, four planes at a time.
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(nx + i), cx), _mm_mul_ps(_mm_load_ps(ny + i), cy)),
+								 _mm_add_ps(_mm_mul_ps(_mm_load_ps(nz + i), cz), _mm_load_ps(d + i)));
+		__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(ax + i), ex), _mm_mul_ps(_mm_load_ps(ay + i), ey)),
+								   _mm_mul_ps(_mm_load_ps(az + i), ez));
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		straddle |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), zero));
+	}
+	if (outside)
+		return OUTSIDE;
+	return straddle ? INTERSECT : INSIDE;
+#else
+	Result result = INSIDE;
+	for (int i = 0; i < 6; ++i)
+	{
+		float dist = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + d[i];
+		float radius = ax[i] * e.x + ay[i] * e.y + az[i] * e.z;
+		if (dist + radius < 0.0f)
+			return OUTSIDE;
+		if (dist - radius < 0.0f)
+			result = INTERSECT;
+	}
+	return result;
+#endif
+}
+
+void SceneBVH::build(const std::vector<Model *> &models)
+{
+	nodes.clear();
+	items.clear();
+	bounds.clear();
+	if (models.empty())
+		return;
+
+	uint32_t count = static_cast<uint32_t>(models.size());
+	std::vector<glm::vec3> centers(count);
+	std::vector<AABB> modelBounds(count);
+	std::vector<uint32_t> order(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		modelBounds[i] = models[i]->getWorldBounds();
+		centers[i] = modelBounds[i].empty() ? glm::vec3(0.0f) : modelBounds[i].center();
+		order[i] = i;
+	}
+
+	nodes.reserve(2 * count);
+	nodes.push_back({});
+	buildNode(0, 0, count, order, centers);
+
+	// Store items in leaf order so every subtree is a contiguous range.
+	items.resize(count);
+	bounds.resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		items[i] = models[order[i]];
+		bounds[i] = modelBounds[order[i]];
+	}
+
+	refitNodes();
+}
+
+void SceneBVH::buildNode(uint32_t node, uint32_t first, uint32_t count,
+						 std::vector<uint32_t> &order, const std::vector<glm::vec3> &centers)
+{
+	nodes[node].first = first;
+	nodes[node].count = count;
+	nodes[node].child = 0;
+	if (count <= kLeafSize)
+		return;
+
+	// Median split along the longest axis of the centroid bounds.
+	AABB centroidBounds;
+	for (uint32_t i = first; i < first + count; ++i)
+		centroidBounds.expand(centers[order[i]]);
+	glm::vec3 size = centroidBounds.max - centroidBounds.min;
+	int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+	uint32_t half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+					 [&](uint32_t a, uint32_t b)
+					 { return centers[a][axis] < centers[b][axis]; });
+
+	uint32_t child = static_cast<uint32_t>(nodes.size());
+	nodes[node].child = child;
+	nodes.push_back({});
+	nodes.push_back({});
+	buildNode(child, first, half, order, centers);
+	buildNode(child + 1, first + half, count - half, order, centers);
+}
+
+bool SceneBVH::refit()
+{
+	bool changed = false;
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const AABB &current = items[i]->getWorldBounds();
+		if (current != bounds[i])
+		{
+			bounds[i] = current;
+			changed = true;
+		}
+	}
+	if (changed)
+		refitNodes();
+	return changed;
+}
+
+void SceneBVH::refitNodes()
+{
+	// Children always follow their parent, so a backwards walk visits children first.
+	for (size_t n = nodes.size(); n-- > 0;)
+	{
+		Node &node = nodes[n];
+		node.bounds = AABB();
+		if (node.child == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				node.bounds.expand(bounds[i]);
+		}
+		else
+		{
+			node.bounds.expand(nodes[node.child].bounds);
+			node.bounds.expand(nodes[node.child + 1].bounds);
+		}
+	}
+}
+
+void SceneBVH::cull(const Frustum &frustum, std::vector<Model *> &visible)
+{
+	lastStats = Stats();
+	if (nodes.empty())
+		return;
+
+	size_t before = visible.size();
+	uint32_t stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const Node &node = nodes[stack[--top]];
+		++lastStats.nodesTested;
+		Frustum::Result result = frustum.test(node.bounds);
+		if (result == Frustum::OUTSIDE)
+			continue;
+
+		if (result == Frustum::INSIDE)
+		{
+			// Whole subtree visible: no further tests.
+			visible.insert(visible.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+		}
+		else if (node.child == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				++lastStats.nodesTested;
+				if (frustum.test(bounds[i]) != Frustum::OUTSIDE)
+					visible.push_back(items[i]);
+			}
+		}
+		else
+		{
+			stack[top++] = node.child + 1;
+			stack[top++] = node.child;
+		}
+	}
+
+	lastStats.visible = visible.size() - before;
+	lastStats.culled = items.size() - lastStats.visible;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "Model.hpp"
+
+// The six clip planes of a view-projection matrix, stored structure-of-arrays so one
+// SSE instruction tests an AABB against four planes. Slots 6 and 7 never reject.
+struct Frustum
+{
+    alignas(16) float nx[8], ny[8], nz[8], d[8];    // Plane normals (pointing inside) and offsets.
+    alignas(16) float ax[8], ay[8], az[8];          // |normal|, for the box projection radius.
+
+    enum Result
+    {
+        OUTSIDE,   // Completely behind at least one plane.
+        INTERSECT, // Straddles at least one plane.
+        INSIDE     // In front of all planes.
+    };
+
+    // Gribb/Hartmann plane extraction from projection * view.
+    explicit Frustum(const glm::mat4 &viewProjection);
+
+    Result test(const AABB &box) const;
+};
+
+// Bounding-volume hierarchy over the world bounds of scene models.
+// Built once over a fixed set of models; refit() follows models that move
+// (bounds are re-read every frame, nodes are only updated when something changed).
+class SceneBVH
+{
+public:
+    // Culling statistics of the last cull().
+    struct Stats
+    {
+        size_t visible = 0;      // Models returned.
+        size_t culled = 0;       // Models rejected.
+        size_t nodesTested = 0;  // Frustum tests performed.
+    };
+
+    // Builds the tree; the models must stay at the same address until the next build.
+    void build(const std::vector<Model *> &models);
+
+    // Re-reads the model bounds and updates the node boxes bottom-up if any changed.
+    // Returns true if the tree was refit.
+    bool refit();
+
+    // Appends every model whose bounds intersect the frustum.
+    void cull(const Frustum &frustum, std::vector<Model *> &visible);
+
+    const Stats &stats() const { return lastStats; }
+    size_t size() const { return items.size(); }
+
+private:
+    static constexpr uint32_t kLeafSize = 4;
+
+    struct Node
+    {
+        AABB bounds;
+        uint32_t first; // First item of the subtree (subtrees cover contiguous item ranges).
+        uint32_t count; // Items in the subtree.
+        uint32_t child; // Left child (right = child + 1); 0 for leaves.
+    };
+
+    std::vector<Node> nodes;     // Node 0 is the root; children always follow their parent.
+    std::vector<Model *> items;  // Models in leaf order.
+    std::vector<AABB> bounds;    // World bounds of items, as last read.
+    Stats lastStats;
+
+    void refitNodes();
+    void buildNode(uint32_t node, uint32_t first, uint32_t count,
+                   std::vector<uint32_t> &order, const std::vector<glm::vec3> &centers);
+};
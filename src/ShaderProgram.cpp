@@ -1,15 +1,13 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
 #include "ShaderProgram.hpp"
 
-// set uniform according to name
-// https://docs.gl/gl4/glUniform
-
 ShaderProgram::ShaderProgram(const std::filesystem::path &VS_file, const std::filesystem::path &FS_file)
 {
 	std::vector<GLuint> shader_ids;
@@ -22,6 +20,9 @@ ShaderProgram::ShaderProgram(const std::filesystem::path &VS_file, const std::fi
 
 		// link all compiled shaders into shader_program
 		ID = link_shader(shader_ids);
+
+		// resolve all uniform locations once; draw code only uses the resulting handles
+		reflectUniforms();
 	}
 	catch (const std::runtime_error &e)
 	{
@@ -31,42 +32,182 @@ ShaderProgram::ShaderProgram(const std::filesystem::path &VS_file, const std::fi
 	}
 }
 
-void ShaderProgram::setUniform(const std::string &name, const float val)
+// FNV-1a; 0 is reserved for empty slots.
+static uint64_t hashName(const char *name, size_t length)
 {
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1)
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < length; ++i)
 	{
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 1099511628211ull;
 	}
-	glUniform1f(loc, val);
+	return hash == 0 ? 1 : hash;
+}
+
+void ShaderProgram::reflectUniforms(void)
+{
+	GLint active = 0, maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &active);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	// Collect every addressable name: arrays are reported once as "name[0]", so add
+	// the bare name and each element.
+	std::vector<std::pair<std::string, GLint>> found;
+	std::vector<char> buffer(static_cast<size_t>(std::max(maxLength, 1)));
+	for (GLint i = 0; i < active; ++i)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+		std::string name(buffer.data(), length);
+
+		GLint location = glGetUniformLocation(ID, name.c_str());
+		if (location == -1)
+			continue; // member of a uniform block, set through its buffer
+
+		found.emplace_back(name, location);
+		if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			std::string base = name.substr(0, name.size() - 3);
+			found.emplace_back(base, location);
+			for (GLint e = 1; e < size; ++e)
+			{
+				std::string element = base + "[" + std::to_string(e) + "]";
+				found.emplace_back(element, glGetUniformLocation(ID, element.c_str()));
+			}
+		}
+	}
+
+	// Size the table for a load factor of at most 1/2.
+	auto table = std::make_shared<UniformTable>();
+	size_t capacity = 16;
+	while (capacity < found.size() * 2)
+		capacity *= 2;
+	table->slots.resize(capacity);
+	for (auto &[name, location] : found)
+	{
+		uint64_t hash = hashName(name.data(), name.size());
+		size_t slot = hash & (capacity - 1);
+		while (table->slots[slot].hash != 0 && table->slots[slot].name != name)
+			slot = (slot + 1) & (capacity - 1);
+		if (table->slots[slot].hash == 0)
+			++table->count;
+		table->slots[slot] = {hash, std::move(name), location};
+	}
+	uniforms = std::move(table);
+}
+
+UniformHandle ShaderProgram::uniform(const std::string &name) const
+{
+	if (!uniforms)
+		return {};
+	const auto &slots = uniforms->slots;
+	uint64_t hash = hashName(name.data(), name.size());
+	size_t mask = slots.size() - 1;
+	for (size_t slot = hash & mask; slots[slot].hash != 0; slot = (slot + 1) & mask)
+	{
+		if (slots[slot].hash == hash && slots[slot].name == name)
+			return {slots[slot].location};
+	}
+	return {};
+}
+
+size_t ShaderProgram::uniformCount() const
+{
+	return uniforms ? uniforms->count : 0;
+}
+
+UniformHandle ShaderProgram::lookupNamed(const std::string &name) const
+{
+	UniformHandle handle = uniform(name);
+	if (!handle.valid())
+		std::cerr << "no uniform with name:" << name << '\n';
+	return handle;
+}
+
+void ShaderProgram::setUniform(UniformHandle handle, const float val) const
+{
+	if (handle.valid())
+		glProgramUniform1f(ID, handle.location, val);
 }
 
-void ShaderProgram::setUniform(const std::string &name, const int val)
+void ShaderProgram::setUniform(UniformHandle handle, const int val) const
 {
-	// TODO: implement
+	if (handle.valid())
+		glProgramUniform1i(ID, handle.location, val);
 }
 
-void ShaderProgram::setUniform(const std::string &name, const glm::vec3 val)
+void ShaderProgram::setUniform(UniformHandle handle, const bool val) const
 {
-	// TODO: get location
-	// glUniform3fv(loc, 1, glm::value_ptr(val));
+	if (handle.valid())
+		glProgramUniform1i(ID, handle.location, val ? 1 : 0);
 }
 
-void ShaderProgram::setUniform(const std::string &name, const glm::vec4 in_vec4)
+void ShaderProgram::setUniform(UniformHandle handle, const glm::ivec2 &val) const
 {
-	// TODO: implement
+	if (handle.valid())
+		glProgramUniform2i(ID, handle.location, val.x, val.y);
 }
 
-void ShaderProgram::setUniform(const std::string &name, const glm::mat3 val)
+void ShaderProgram::setUniform(UniformHandle handle, const glm::vec2 &val) const
 {
-	// TODO: get location
-	// glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+	if (handle.valid())
+		glProgramUniform2f(ID, handle.location, val.x, val.y);
 }
 
-void ShaderProgram::setUniform(const std::string &name, const glm::mat4 val)
+void ShaderProgram::setUniform(UniformHandle handle, const glm::vec3 &val) const
 {
-	// TODO: implement
+	if (handle.valid())
+		glProgramUniform3fv(ID, handle.location, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle handle, const glm::vec4 &val) const
+{
+	if (handle.valid())
+		glProgramUniform4fv(ID, handle.location, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle handle, const glm::mat3 &val) const
+{
+	if (handle.valid())
+		glProgramUniformMatrix3fv(ID, handle.location, 1, GL_FALSE, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle handle, const glm::mat4 &val) const
+{
+	if (handle.valid())
+		glProgramUniformMatrix4fv(ID, handle.location, 1, GL_FALSE, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(const std::string &name, const float val) const
+{
+	setUniform(lookupNamed(name), val);
+}
+
+void ShaderProgram::setUniform(const std::string &name, const int val) const
+{
+	setUniform(lookupNamed(name), val);
+}
+
+void ShaderProgram::setUniform(const std::string &name, const glm::vec3 val) const
+{
+	setUniform(lookupNamed(name), val);
+}
+
+void ShaderProgram::setUniform(const std::string &name, const glm::vec4 val) const
+{
+	setUniform(lookupNamed(name), val);
+}
+
+void ShaderProgram::setUniform(const std::string &name, const glm::mat3 val) const
+{
+	setUniform(lookupNamed(name), val);
+}
+
+void ShaderProgram::setUniform(const std::string &name, const glm::mat4 val) const
+{
+	setUniform(lookupNamed(name), val);
 }
 
 std::string ShaderProgram::getShaderInfoLog(const GLuint obj)
@@ -82,14 +223,17 @@ std::string ShaderProgram::getShaderInfoLog(const GLuint obj)
 
 std::string ShaderProgram::getProgramInfoLog(const GLuint obj)
 {
-	// TODO: implement, print info
-	return "Not implemented";
+	GLint log_length = 0;
+	glGetProgramiv(obj, GL_INFO_LOG_LENGTH, &log_length);
+	if (log_length <= 0) return "";
+
+	std::vector<char> log(log_length);
+	glGetProgramInfoLog(obj, log_length, nullptr, log.data());
+	return std::string(log.data());
 }
 
 GLuint ShaderProgram::compile_shader(const std::filesystem::path &source_file, const GLenum type)
 {
-	// implement, try to compile, check for error; if any, print compiler result (or print allways, if you want to see warnings as well)
-	// if err, throw error
 	std::string source = textFileRead(source_file);
 	const char *source_cstr = source.c_str();
 	GLuint shader_h = glCreateShader(type);
@@ -124,7 +268,6 @@ GLuint ShaderProgram::link_shader(const std::vector<GLuint> shader_ids)
 
 	glLinkProgram(prog_h);
 	
-	// implement: check link result, print info & throw error (if any)
 	// Check link result
     GLint success;
     glGetProgramiv(prog_h, GL_LINK_STATUS, &success);
@@ -1,17 +1,28 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Pre-resolved uniform location; look it up once with ShaderProgram::uniform() and keep it.
+struct UniformHandle
+{
+	GLint location{-1}; // -1 = not an active uniform, setters ignore it
+
+	bool valid() const { return location != -1; }
+};
 
 class ShaderProgram
 {
 public:
 	// you can add more constructors for pipeline with GS, TS etc.
 	ShaderProgram(void) = default;															   // does nothing
-	ShaderProgram(const std::filesystem::path &VS_file, const std::filesystem::path &FS_file); // TODO: implementation of load, compile, and link shader
+	ShaderProgram(const std::filesystem::path &VS_file, const std::filesystem::path &FS_file); // loads, compiles and links the two stages
 
 	void activate(void) const { glUseProgram(ID); }; // activate shader
 	void deactivate(void) { glUseProgram(0); };		 // deactivate current shader program (i.e. activate shader no. 0)
@@ -21,30 +32,63 @@ public:
 		deactivate();
 		glDeleteProgram(ID);
 		ID = 0;
+		uniforms.reset();
 	}
 
 	GLuint getID() const { return ID; } // Add getter for ID
 
-	// set uniform according to name
-	// https://docs.gl/gl4/glUniform
-	void setUniform(const std::string &name, const float val);
-	void setUniform(const std::string &name, const int val); // TODO: implement
-	void setUniform(const std::string &name, const glm::vec3 val);
-	void setUniform(const std::string &name, const glm::vec4 val); // TODO: implement
-	void setUniform(const std::string &name, const glm::mat3 val);
-	void setUniform(const std::string &name, const glm::mat4 val); // TODO: implement
+	// Resolves a uniform name to a handle using the table built after linking (no GL call).
+	// Array elements and struct members use their GLSL names, e.g. "pointLights[1].position".
+	UniformHandle uniform(const std::string &name) const;
+	size_t uniformCount() const; // number of active uniform locations found by reflection
+
+	// set uniform through a pre-resolved handle (glProgramUniform*, program need not be active)
+	// https://docs.gl/gl4/glProgramUniform
+	void setUniform(UniformHandle handle, const float val) const;
+	void setUniform(UniformHandle handle, const int val) const;
+	void setUniform(UniformHandle handle, const bool val) const;
+	void setUniform(UniformHandle handle, const glm::ivec2 &val) const;
+	void setUniform(UniformHandle handle, const glm::vec2 &val) const;
+	void setUniform(UniformHandle handle, const glm::vec3 &val) const;
+	void setUniform(UniformHandle handle, const glm::vec4 &val) const;
+	void setUniform(UniformHandle handle, const glm::mat3 &val) const;
+	void setUniform(UniformHandle handle, const glm::mat4 &val) const;
+
+	// set uniform according to name (table lookup, then the handle setter)
+	void setUniform(const std::string &name, const float val) const;
+	void setUniform(const std::string &name, const int val) const;
+	void setUniform(const std::string &name, const glm::vec3 val) const;
+	void setUniform(const std::string &name, const glm::vec4 val) const;
+	void setUniform(const std::string &name, const glm::mat3 val) const;
+	void setUniform(const std::string &name, const glm::mat4 val) const;
 
 private:
+	// Open-addressing hash table of active uniforms, filled once after linking.
+	// Copies of a ShaderProgram (every Mesh holds one) share the same table.
+	struct UniformTable
+	{
+		struct Slot
+		{
+			uint64_t hash{0}; // 0 = empty slot
+			std::string name;
+			GLint location{-1};
+		};
+		std::vector<Slot> slots; // size is a power of two
+		size_t count{0};
+	};
+
 	GLuint ID{0};									 // default = 0, empty shader
-	std::string getShaderInfoLog(const GLuint obj);	 // TODO implement: print compiler output
-	std::string getProgramInfoLog(const GLuint obj); // TODO implement: print linker output
+	std::shared_ptr<const UniformTable> uniforms;	 // shared by copies; null until linked
+
+	void reflectUniforms(void);
+	UniformHandle lookupNamed(const std::string &name) const; // uniform() plus a warning if missing
+	std::string getShaderInfoLog(const GLuint obj);	 // compiler output of a shader object
+	std::string getProgramInfoLog(const GLuint obj); // linker output of a program object
 
+	// Loads and compiles one stage; prints the compiler output and throws on failure
 	GLuint compile_shader(const std::filesystem::path &source_file, const GLenum type);
-	// TODO implement: try to load and compile shader; check for shader compilation error, if any, print compiler output using
-	// getShaderInfoLog() function
 
-	// TODO implement: try to link all shader IDs to final program; check for linker error, if any, print output using
-	// getProgramInfoLog() function
+	// Links the compiled stages into the program; prints the linker output and throws on failure
 	GLuint link_shader(const std::vector<GLuint> shader_ids);
 
 	std::string textFileRead(const std::filesystem::path &filename); // load text file
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ShadowMaps.hpp"
+
+void ShadowMaps::setProgram(const ShaderProgram &program)
+{
+	casterProgram = program;
+	lightMatrixUniform = casterProgram.uniform("uLightViewProjection");
+}
+
+void ShadowMaps::create()
+{
+	if (texture != 0)
+		glDeleteTextures(1, &texture);
+	if (framebuffer == 0)
+		glCreateFramebuffers(1, &framebuffer);
+
+	textureResolution = settings.resolution;
+	textureLayers = activeCascades;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+	glTextureStorage3D(texture, 1, GL_DEPTH_COMPONENT32F, textureResolution, textureResolution, textureLayers);
+	// Hardware comparison with bilinear weights: every tap is already a 2x2 PCF.
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	const GLfloat unshadowed[] = {1.0f, 1.0f, 1.0f, 1.0f};
+	glTextureParameterfv(texture, GL_TEXTURE_BORDER_COLOR, unshadowed);
+
+	glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+	glNamedFramebufferReadBuffer(framebuffer, GL_NONE);
+	glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, texture, 0, 0);
+	if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Error: Shadow map framebuffer is incomplete\n";
+		throw std::runtime_error("Shadow map creation failed");
+	}
+}
+
+void ShadowMaps::readQueries()
+{
+	queryFrame = (queryFrame + 1) % kQueryFrames;
+	for (int i = 0; i < kMaxShadowCascades; ++i)
+	{
+		if (!queryPending[queryFrame][i])
+			continue;
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(queries[queryFrame][i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint64 start = 0, stop = 0;
+			glGetQueryObjectui64v(queries[queryFrame][i][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(queries[queryFrame][i][1], GL_QUERY_RESULT, &stop);
+			lastStats.gpuMs[i] = static_cast<double>(stop - start) * 1e-6;
+		}
+		queryPending[queryFrame][i] = false;
+	}
+}
+
+bool ShadowMaps::fit(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightDirection)
+{
+	readQueries();
+	activeCascades = std::clamp(settings.cascades, 0, kMaxShadowCascades);
+	for (int i = activeCascades; i < kMaxShadowCascades; ++i)
+		lastStats.gpuMs[i] = 0.0;
+	// Nothing to shadow with the sun below the horizon.
+	active = activeCascades > 0 && casterProgram.getID() != 0 && lightDirection.y < 0.0f;
+	if (!active)
+		return false;
+
+	// glm::perspective: [2][2] = -(f + n) / (f - n), [3][2] = -2fn / (f - n).
+	const float tanHalfX = 1.0f / projection[0][0];
+	const float tanHalfY = 1.0f / projection[1][1];
+	const float nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+	const float farDepth = std::max(settings.distance, nearDepth * 2.0f);
+	const glm::mat4 inverseView = glm::inverse(view);
+
+	const glm::vec3 direction = glm::normalize(lightDirection);
+	const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const float resolution = static_cast<float>(settings.resolution);
+
+	float splitNear = nearDepth;
+	for (int i = 0; i < activeCascades; ++i)
+	{
+		float t = static_cast<float>(i + 1) / activeCascades;
+		float logSplit = nearDepth * std::pow(farDepth / nearDepth, t);
+		float uniformSplit = nearDepth + (farDepth - nearDepth) * t;
+		float splitFar = settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+
+		// Bounding sphere of the slice's eight corners.
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (int c = 0; c < 8; ++c)
+		{
+			float depth = c < 4 ? splitNear : splitFar;
+			float x = (c & 1 ? 1.0f : -1.0f) * depth * tanHalfX;
+			float y = (c & 2 ? 1.0f : -1.0f) * depth * tanHalfY;
+			corners[c] = glm::vec3(inverseView * glm::vec4(x, y, -depth, 1.0f));
+			center += corners[c];
+		}
+		center *= 1.0f / 8.0f;
+		float radius = 0.0f;
+		for (const glm::vec3 &corner : corners)
+			radius = std::max(radius, glm::length(corner - center));
+		radius = std::ceil(radius * 16.0f) / 16.0f; // Keep the size from flickering with rounding.
+
+		// Orthographic box around the sphere, reaching casterDistance further towards the sun.
+		float backOff = radius + settings.casterDistance;
+		glm::mat4 lightView = glm::lookAt(center - direction * backOff, center, up);
+		glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, backOff + radius);
+
+		// Snap the world origin to a texel so the map moves in whole texels.
+		glm::vec4 origin = lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		float texelsX = origin.x * resolution * 0.5f;
+		float texelsY = origin.y * resolution * 0.5f;
+		lightProjection[3][0] += (std::round(texelsX) - texelsX) * 2.0f / resolution;
+		lightProjection[3][1] += (std::round(texelsY) - texelsY) * 2.0f / resolution;
+
+		cascades[i].viewProjection = lightProjection * lightView;
+		cascades[i].splitDepth = splitFar;
+		cascades[i].texelSize = 2.0f * radius / resolution;
+		splitNear = splitFar;
+	}
+
+	if (texture == 0 || textureResolution != settings.resolution || textureLayers != activeCascades)
+		create();
+	return true;
+}
+
+void ShadowMaps::writeUniforms(LightData &lights) const
+{
+	lights.shadowCascades = active ? activeCascades : 0;
+	lights.shadowPcfRadius = std::max(settings.pcfRadius, 0);
+	lights.shadowTexelSize = 1.0f / static_cast<float>(std::max(settings.resolution, 1));
+
+	// Clip space [-1, 1] to texture coordinates and depth [0, 1].
+	glm::mat4 toTexture = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+	for (int i = 0; i < kMaxShadowCascades; ++i)
+	{
+		bool used = i < lights.shadowCascades;
+		lights.shadowMatrices[i] = used ? toTexture * cascades[i].viewProjection : glm::mat4(1.0f);
+		lights.cascadeSplits[i] = used ? cascades[i].splitDepth : 0.0f;
+		lights.cascadeTexelSizes[i] = used ? cascades[i].texelSize : 0.0f;
+	}
+}
+
+void ShadowMaps::begin(int index)
+{
+	GLuint (&pair)[2] = queries[queryFrame][index];
+	if (pair[0] == 0)
+		glCreateQueries(GL_TIMESTAMP, 2, pair);
+	glQueryCounter(pair[0], GL_TIMESTAMP);
+
+	glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, texture, 0, index);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, textureResolution, textureResolution);
+	const GLfloat farthest = 1.0f;
+	glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &farthest);
+
+	// Casters between the sun and the box's near plane are flattened onto it instead of clipped;
+	// the slope-scaled offset keeps lit surfaces from shadowing themselves.
+	glEnable(GL_DEPTH_CLAMP);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	casterProgram.setUniform(lightMatrixUniform, cascades[index].viewProjection);
+}
+
+void ShadowMaps::end(int index)
+{
+	glQueryCounter(queries[queryFrame][index][1], GL_TIMESTAMP);
+	queryPending[queryFrame][index] = true;
+}
+
+void ShadowMaps::finish(int viewportWidth, int viewportHeight)
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	if (texture != 0)
+		glBindTextureUnit(kShadowTextureUnit, texture);
+}
+
+void ShadowMaps::clear()
+{
+	for (int frame = 0; frame < kQueryFrames; ++frame)
+	{
+		for (int i = 0; i < kMaxShadowCascades; ++i)
+		{
+			if (queries[frame][i][0] != 0)
+				glDeleteQueries(2, queries[frame][i]);
+			queries[frame][i][0] = queries[frame][i][1] = 0;
+			queryPending[frame][i] = false;
+		}
+	}
+	if (texture != 0)
+		glDeleteTextures(1, &texture);
+	if (framebuffer != 0)
+		glDeleteFramebuffers(1, &framebuffer);
+	texture = framebuffer = 0;
+	textureResolution = textureLayers = 0;
+	active = false;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ShaderProgram.hpp"
+#include "UniformBlocks.hpp"
+
+// Texture unit of the cascade array (sampler2DArrayShadow shadowMap in basic.frag).
+constexpr GLuint kShadowTextureUnit = 3;
+
+// Cascaded shadow maps for the sun. The view frustum up to settings.distance is split into
+// cascades (practical split scheme: a blend of logarithmic and uniform splits); each cascade is
+// an orthographic view along the light around the bounding sphere of its frustum slice, so its
+// size does not change as the camera turns, and its origin is snapped to whole shadow texels so
+// the map does not shimmer as the camera moves. All cascades are layers of one depth texture
+// array; basic.frag picks the cascade from the view depth and filters (2r + 1)^2 comparisons.
+//
+// Per frame: fit(), writeUniforms(), then for each cascade begin(i) / draw the casters / end(i),
+// then finish() to return to the default framebuffer.
+class ShadowMaps
+{
+public:
+    struct Settings
+    {
+        int cascades = 4;              // 0 disables shadows, at most kMaxShadowCascades.
+        int resolution = 2048;         // Texels per side of each cascade.
+        float distance = 80.0f;        // View depth covered by the cascades.
+        float splitLambda = 0.75f;     // 0 = uniform splits, 1 = logarithmic.
+        float casterDistance = 50.0f;  // How far towards the sun casters outside a cascade are kept.
+        int pcfRadius = 1;
+    };
+
+    struct Cascade
+    {
+        glm::mat4 viewProjection{1.0f}; // Light clip space; cull the casters with it.
+        float splitDepth = 0.0f;        // View depth where the cascade ends.
+        float texelSize = 0.0f;         // World size of one texel.
+    };
+
+    // GPU time of each cascade's pass, from the newest finished frame (0 until measured).
+    struct Stats
+    {
+        double gpuMs[kMaxShadowCascades] = {};
+    };
+
+    Settings settings;
+
+    ShadowMaps() = default;
+    ShadowMaps(const ShadowMaps &) = delete;
+    ShadowMaps &operator=(const ShadowMaps &) = delete;
+    ~ShadowMaps() { clear(); }
+
+    // Depth-only caster program (shadow.vert / depth.frag).
+    void setProgram(const ShaderProgram &program);
+    const ShaderProgram &program() const { return casterProgram; }
+
+    // Fits the cascades to the camera (glm::perspective projection) for light travelling along
+    // lightDirection. Returns false when shadows are off or the sun is below the horizon.
+    bool fit(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &lightDirection);
+
+    // Copies the cascades of the last fit() into the light block (no shadows if it failed).
+    void writeUniforms(LightData &lights) const;
+
+    int cascadeCount() const { return active ? activeCascades : 0; }
+    const Cascade &cascade(int index) const { return cascades[index]; }
+
+    // Renders into cascade index: binds its layer, clears it and sets the caster program up.
+    void begin(int index);
+    void end(int index);
+
+    // Back to the default framebuffer and viewport; binds the maps for the scene pass.
+    void finish(int viewportWidth, int viewportHeight);
+
+    // Releases the maps and queries (call while the GL context is alive).
+    void clear();
+
+    const Stats &stats() const { return lastStats; }
+
+private:
+    ShaderProgram casterProgram;
+    UniformHandle lightMatrixUniform;
+    Cascade cascades[kMaxShadowCascades];
+    int activeCascades = 0;
+    bool active = false;
+
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    int textureResolution = 0, textureLayers = 0;
+
+    // GL_TIMESTAMP pair around each cascade, double-buffered and read a frame late. Timestamps
+    // rather than GL_TIME_ELAPSED so they can sit inside FrameProfiler's elapsed-time phases.
+    static constexpr int kQueryFrames = 2;
+    GLuint queries[kQueryFrames][kMaxShadowCascades][2] = {};
+    bool queryPending[kQueryFrames][kMaxShadowCascades] = {};
+    int queryFrame = 0;
+
+    Stats lastStats;
+
+    void create();
+    void readQueries();
+};
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Simulation.hpp"
+
+SimulationState SimulationState::interpolate(const SimulationState &a, const SimulationState &b, float alpha)
+{
+	SimulationState blended = b;
+	blended.player.position = glm::mix(a.player.position, b.player.position, alpha);
+	blended.sunDirection = glm::normalize(glm::mix(a.sunDirection, b.sunDirection, alpha));
+	for (int i = 0; i < 3; ++i)
+		blended.sphereOrigins[i] = glm::mix(a.sphereOrigins[i], b.sphereOrigins[i], alpha);
+	return blended;
+}
+
+uint64_t SimulationState::hash() const
+{
+	uint64_t h = 1469598103934665603ull;
+	auto add = [&](const void *data, size_t size)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i)
+			h = (h ^ bytes[i]) * 1099511628211ull;
+	};
+	unsigned char grounded = player.grounded ? 1 : 0;
+	add(&tick, sizeof(tick));
+	add(&player.position, sizeof(player.position));
+	add(&player.velocity, sizeof(player.velocity));
+	add(&grounded, sizeof(grounded));
+	add(&sunDirection, sizeof(sunDirection));
+	add(sphereOrigins, sizeof(sphereOrigins));
+	return h;
+}
+
+void Simulation::reset(const glm::vec3 &playerPosition)
+{
+	current = SimulationState();
+	current.player.position = playerPosition;
+	animate(current);
+}
+
+void Simulation::animate(SimulationState &state) const
+{
+	// Time comes from the tick count, so it never accumulates rounding error.
+	float time = static_cast<float>(static_cast<double>(state.tick) * stepLength);
+
+	float angle = time * 15.0f;
+	state.sunDirection = glm::normalize(glm::vec3(std::sin(glm::radians(angle)), std::cos(glm::radians(angle)), 0.0f));
+
+	// Spheres orbit (no rotation)
+	float angle1 = time * 1.0f;
+	state.sphereOrigins[0] = glm::vec3(-2.0f + 3.0f * std::cos(angle1), 7.0f, 3.0f * std::sin(angle1));
+
+	float angle2 = time * 1.5f + 2.0f * 3.1415926535f / 3.0f;
+	state.sphereOrigins[1] = glm::vec3(-2.0f + 3.0f * std::cos(angle2), 7.0f + 3.0f * std::sin(angle2), 0.0f);
+
+	float angle3 = time * 2.0f + 4.0f * 3.1415926535f / 3.0f;
+	state.sphereOrigins[2] = glm::vec3(-2.0f, 7.0f + 3.0f * std::cos(angle3), 3.0f * std::sin(angle3));
+}
+
+void Simulation::step(const PlayerController::Input &input)
+{
+	++current.tick;
+	animate(current);
+
+	// The sun is the only solid object that moves
+	glm::vec3 sunOrigin = current.sunDirection * sunDistance;
+	collision.clearDynamic();
+	collision.addDynamic(AABB{sunOrigin - glm::vec3(0.5f), sunOrigin + glm::vec3(0.5f)});
+
+	controller.step(current.player, input, static_cast<float>(stepLength), collision);
+}
+
+void SimulationThread::start(Simulation &target)
+{
+	stop();
+	simulation = &target;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		previousState = currentState = simulation->state();
+		currentTime = Clock::now();
+		dropped = 0;
+		running = true;
+	}
+	worker = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wake.notify_all();
+	if (worker.joinable())
+		worker.join();
+}
+
+void SimulationThread::setInput(const PlayerController::Input &newInput)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	input = newInput;
+}
+
+float SimulationThread::sample(SimulationState &previous, SimulationState &current) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	previous = previousState;
+	current = currentState;
+
+	// Rendering runs one step behind the simulation and blends toward the newest state.
+	double step = simulation ? simulation->stepSeconds() : 1.0 / Simulation::kDefaultRate;
+	double alpha = std::chrono::duration<double>(Clock::now() - currentTime).count() / step;
+	return static_cast<float>(std::clamp(alpha, 0.0, 1.0));
+}
+
+uint64_t SimulationThread::droppedSteps() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return dropped;
+}
+
+void SimulationThread::run()
+{
+	const double step = simulation->stepSeconds();
+	Clock::time_point last = Clock::now();
+	double accumulator = 0.0;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running)
+	{
+		PlayerController::Input stepInput = input;
+		Clock::time_point now = Clock::now();
+		accumulator += std::chrono::duration<double>(now - last).count();
+		last = now;
+
+		// After a stall, drop whole steps instead of spiralling into ever longer catch-ups.
+		if (accumulator > kMaxCatchUp)
+		{
+			uint64_t skipped = static_cast<uint64_t>((accumulator - kMaxCatchUp) / step);
+			accumulator -= skipped * step;
+			dropped += skipped;
+		}
+
+		// Step without holding the lock; publish each state as soon as it exists.
+		while (accumulator >= step)
+		{
+			lock.unlock();
+			simulation->step(stepInput);
+			accumulator -= step;
+			lock.lock();
+			previousState = currentState;
+			currentState = simulation->state();
+			currentTime = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(accumulator));
+		}
+
+		wake.wait_until(lock, last + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(step - accumulator)),
+						[this]
+						{ return !running; });
+	}
+}
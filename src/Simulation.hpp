@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "CollisionGrid.hpp"
+#include "PlayerController.hpp"
+
+// Everything in the scene that advances with time.
+struct SimulationState
+{
+    uint64_t tick = 0; // Number of fixed steps taken; simulation time is tick * step length.
+    PlayerController::State player;
+    glm::vec3 sunDirection{0.0f, 1.0f, 0.0f};
+    glm::vec3 sphereOrigins[3]{};
+
+    // Blend for rendering between two consecutive states (alpha 0 = a, 1 = b).
+    static SimulationState interpolate(const SimulationState &a, const SimulationState &b, float alpha);
+
+    // FNV-1a over the exact bit patterns, for bit-exact regression checks.
+    uint64_t hash() const;
+};
+
+// Fixed-step simulation of the player and the animated scene objects. It never touches GL or
+// the window, and every step advances exactly stepSeconds(), so the results depend only on the
+// step length and the inputs, not on the frame rate or vsync.
+class Simulation
+{
+public:
+    static constexpr double kDefaultRate = 120.0;
+
+    CollisionGrid collision;     // Static walls; the sun is re-added as a dynamic box every step.
+    PlayerController controller; // Player shape, gravity and floor query.
+    float sunDistance = 20.0f;
+
+    void setRate(double stepsPerSecond) { stepLength = 1.0 / stepsPerSecond; }
+    double stepSeconds() const { return stepLength; }
+
+    // Restarts at tick 0 with the player at the given position.
+    void reset(const glm::vec3 &playerPosition);
+
+    // Advances by one fixed step with the input held for the whole step.
+    void step(const PlayerController::Input &input);
+
+    const SimulationState &state() const { return current; }
+
+private:
+    double stepLength = 1.0 / kDefaultRate;
+    SimulationState current;
+
+    // Sun and spheres are pure functions of time.
+    void animate(SimulationState &state) const;
+};
+
+// Runs a Simulation on its own thread at its fixed rate. The render thread hands in the latest
+// input and samples the two newest states plus the blend factor for the current time, so a slow
+// frame never delays the simulation and a slow step never blocks a frame for more than a copy.
+class SimulationThread
+{
+public:
+    ~SimulationThread() { stop(); }
+
+    // The simulation must stay alive until stop().
+    void start(Simulation &simulation);
+    void stop();
+
+    void setInput(const PlayerController::Input &input);
+
+    // Copies the previous and current states; returns how far the present lies between them.
+    float sample(SimulationState &previous, SimulationState &current) const;
+
+    // Steps skipped because the simulation fell too far behind (e.g. while debugging).
+    uint64_t droppedSteps() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // At most this much real time is caught up after a stall; the rest is dropped.
+    static constexpr double kMaxCatchUp = 0.25;
+
+    Simulation *simulation = nullptr;
+    std::thread worker;
+    bool running = false;
+
+    mutable std::mutex mutex; // Guards everything below.
+    std::condition_variable wake;
+    PlayerController::Input input;
+    SimulationState previousState;
+    SimulationState currentState;
+    Clock::time_point currentTime; // Real time the current state corresponds to.
+    uint64_t dropped = 0;
+
+    void run();
+};
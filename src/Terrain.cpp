@@ -0,0 +1,492 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Terrain.hpp"
+#include "UniformBlocks.hpp"
+
+void Terrain::load(const std::string &heightmapPath, const std::string &texturePath, const ShaderProgram &program,
+				   int width, int depth)
+{
+	clear();
+
+	heights = loadHeightmap(heightmapPath, width, depth);
+
+	int quads = 1;
+	while (quads < settings.chunkQuads)
+		quads <<= 1;
+	settings.chunkQuads = quads;
+	settings.lodLevels = std::clamp(settings.lodLevels, 1, static_cast<int>(std::log2(quads)) + 1);
+	settings.unloadDistance = std::max(settings.unloadDistance, settings.loadDistance);
+
+	columns = heights.columns;
+	rows = heights.rows;
+	chunksX = std::max(1, (columns - 1 + quads - 1) / quads);
+	chunksZ = std::max(1, (rows - 1 + quads - 1) / quads);
+	chunks.assign(static_cast<size_t>(chunksX) * chunksZ, Chunk());
+	computeBounds();
+
+	shader = program;
+	modelUniform = shader.uniform("uM_m");
+	samplerUniform = shader.uniform("textureSampler");
+	textureLayerUniform = shader.uniform("uTextureLayer");
+	chunkBaseUniform = shader.uniform("uChunkBase");
+	chunkQuadsUniform = shader.uniform("uChunkQuads");
+	gridSizeUniform = shader.uniform("uGridSize");
+	spacingUniform = shader.uniform("uSpacing");
+	heightOffsetUniform = shader.uniform("uHeightOffset");
+	heightRangeUniform = shader.uniform("uHeightRange");
+	skirtDepthUniform = shader.uniform("uSkirtDepth");
+	texScaleUniform = shader.uniform("uTexScale");
+	tileLayerUniform = shader.uniform("uTileLayer");
+	texture = texturePath.empty() ? nullptr : AssetManager::instance().loadTexture(texturePath);
+	materialIndex = MaterialBuffer::instance().acquire(MaterialData());
+
+	// Terrain-wide uniforms; only uChunkBase changes per draw.
+	shader.setUniform(chunkQuadsUniform, quads);
+	shader.setUniform(gridSizeUniform, glm::ivec2(columns, rows));
+	shader.setUniform(spacingUniform, spacing);
+	shader.setUniform(heightOffsetUniform, heightScale * heights.offset);
+	shader.setUniform(heightRangeUniform, heightScale * heights.range);
+	shader.setUniform(skirtDepthUniform, heightScale + spacing);
+	shader.setUniform(texScaleUniform, glm::vec2(settings.textureRepeat) / glm::vec2(std::max(columns - 1, 1), std::max(rows - 1, 1)));
+
+	createAtlas();
+	glCreateVertexArrays(1, &vao);
+	buildIndices();
+	glVertexArrayElementBuffer(vao, indexBuffer);
+
+	lastStats.totalChunks = chunks.size();
+	lastStats.sourceBytes = heights.bytes();
+
+	stopping = false;
+	loader = std::thread(&Terrain::loaderLoop, this);
+
+	std::cout << "Terrain: " << columns << "x" << rows << " samples in " << chunksX << "x" << chunksZ
+			  << " chunks of " << quads << " quads, " << settings.lodLevels << " LOD levels, "
+			  << freeLayers.size() << " resident tiles\n";
+}
+
+void Terrain::createAtlas()
+{
+	// Enough layers for every chunk that can be within unloadDistance of the eye at once: a square
+	// of that radius overlaps at most ceil(2r / chunk size) + 1 chunks per axis.
+	tileSide = settings.chunkQuads + 3;
+	const float chunkSize = settings.chunkQuads * spacing;
+	const int perAxis = static_cast<int>(std::ceil(2.0f * settings.unloadDistance / chunkSize)) + 2;
+	const int layers = std::min(chunksX, perAxis) * std::min(chunksZ, perAxis);
+
+	GLint maxSize = 0, maxLayers = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	if (tileSide > maxSize || layers > maxLayers)
+	{
+		std::cerr << "Error: Terrain tile atlas of " << layers << " layers of " << tileSide << "x" << tileSide
+				  << " exceeds the texture limits (" << maxLayers << " layers of " << maxSize << "x" << maxSize
+				  << "); lower chunk_quads or unload_distance\n";
+		throw std::runtime_error("Terrain tile atlas too large");
+	}
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &tileAtlas);
+	glTextureStorage3D(tileAtlas, 1, GL_R16, tileSide, tileSide, layers);
+	glTextureParameteri(tileAtlas, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(tileAtlas, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(tileAtlas, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(tileAtlas, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Popped from the back, so the low layers are used first.
+	freeLayers.clear();
+	for (int layer = layers - 1; layer >= 0; --layer)
+		freeLayers.push_back(layer);
+	lastStats.textureBytes = static_cast<size_t>(layers) * tileSide * tileSide * sizeof(uint16_t);
+}
+
+bool Terrain::contains(float worldX, float worldZ) const
+{
+	if (!loaded())
+		return false;
+	glm::vec2 half = glm::vec2(columns - 1, rows - 1) * (0.5f * spacing);
+	return std::abs(worldX - origin.x) <= half.x && std::abs(worldZ - origin.z) <= half.y;
+}
+
+float Terrain::heightAt(float worldX, float worldZ) const
+{
+	if (!loaded())
+		return origin.y;
+
+	float gx = std::clamp((worldX - origin.x) / spacing + (columns - 1) * 0.5f, 0.0f, static_cast<float>(columns - 1));
+	float gz = std::clamp((worldZ - origin.z) / spacing + (rows - 1) * 0.5f, 0.0f, static_cast<float>(rows - 1));
+	int x = static_cast<int>(gx);
+	int z = static_cast<int>(gz);
+	float fx = gx - x, fz = gz - z;
+	float top = sample(x, z) + (sample(x + 1, z) - sample(x, z)) * fx;
+	float bottom = sample(x, z + 1) + (sample(x + 1, z + 1) - sample(x, z + 1)) * fx;
+	return origin.y + top + (bottom - top) * fz;
+}
+
+float Terrain::sample(int x, int z) const
+{
+	x = std::clamp(x, 0, columns - 1);
+	z = std::clamp(z, 0, rows - 1);
+	return heightScale * heights.normalized(static_cast<size_t>(z) * columns + x);
+}
+
+size_t Terrain::verticesPerChunk() const
+{
+	size_t side = settings.chunkQuads + 1;
+	return side * side + 4 * side; // Grid, then the four skirts.
+}
+
+void Terrain::computeBounds()
+{
+	const int quads = settings.chunkQuads;
+	for (int cz = 0; cz < chunksZ; ++cz)
+	{
+		for (int cx = 0; cx < chunksX; ++cx)
+		{
+			int x0 = cx * quads, x1 = std::min(x0 + quads, columns - 1);
+			int z0 = cz * quads, z1 = std::min(z0 + quads, rows - 1);
+			uint16_t lo = 0xFFFF, hi = 0;
+			for (int z = z0; z <= z1; ++z)
+			{
+				const uint16_t *row = heights.samples.data() + static_cast<size_t>(z) * columns;
+				for (int x = x0; x <= x1; ++x)
+				{
+					lo = std::min(lo, row[x]);
+					hi = std::max(hi, row[x]);
+				}
+			}
+			const float toWorld = heightScale * heights.range / 65535.0f;
+			const float base = heightScale * heights.offset;
+			const glm::vec2 half = glm::vec2(columns - 1, rows - 1) * 0.5f;
+			Chunk &chunk = chunks[static_cast<size_t>(cz) * chunksX + cx];
+			chunk.bounds.min = origin + glm::vec3((x0 - half.x) * spacing, base + lo * toWorld, (z0 - half.y) * spacing);
+			chunk.bounds.max = origin + glm::vec3((x1 - half.x) * spacing, base + hi * toWorld, (z1 - half.y) * spacing);
+		}
+	}
+}
+
+void Terrain::buildIndices()
+{
+	// Vertex ids of every chunk (decoded the same way by terrain.vert): (quads + 1)^2 grid vertices
+	// row by row, then four skirts (z = 0 edge, z = quads edge, x = 0 edge, x = quads edge) of
+	// quads + 1 vertices each.
+	const GLuint quads = settings.chunkQuads;
+	const GLuint side = quads + 1;
+	const GLuint skirtBase = side * side;
+	auto grid = [&](GLuint i, GLuint j)
+	{ return j * side + i; };
+	auto border = [&](int edge, GLuint t)
+	{
+		switch (edge)
+		{
+		case 0:
+			return grid(t, 0);
+		case 1:
+			return grid(t, quads);
+		case 2:
+			return grid(0, t);
+		default:
+			return grid(quads, t);
+		}
+	};
+
+	std::vector<GLuint> indices;
+	lodFirst.clear();
+	lodCount.clear();
+	for (int lod = 0; lod < settings.lodLevels; ++lod)
+	{
+		const GLuint step = 1u << lod;
+		lodFirst.push_back(static_cast<GLsizei>(indices.size()));
+		for (GLuint j = 0; j < quads; j += step)
+		{
+			for (GLuint i = 0; i < quads; i += step)
+			{
+				GLuint topLeft = grid(i, j), topRight = grid(i + step, j);
+				GLuint bottomLeft = grid(i, j + step), bottomRight = grid(i + step, j + step);
+				indices.insert(indices.end(), {topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight});
+			}
+		}
+		// Skirts hang from the vertices this level actually uses.
+		for (int edge = 0; edge < 4; ++edge)
+		{
+			for (GLuint t = 0; t < quads; t += step)
+			{
+				GLuint a = border(edge, t), b = border(edge, t + step);
+				GLuint skirtA = skirtBase + edge * side + t, skirtB = skirtBase + edge * side + t + step;
+				indices.insert(indices.end(), {a, skirtA, b, b, skirtA, skirtB});
+			}
+		}
+		lodCount.push_back(static_cast<GLsizei>(indices.size()) - lodFirst.back());
+	}
+
+	glCreateBuffers(1, &indexBuffer);
+	if (verticesPerChunk() <= 0xFFFF)
+	{
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		glNamedBufferStorage(indexBuffer, shortIndices.size() * sizeof(GLushort), shortIndices.data(), 0);
+		indexType = GL_UNSIGNED_SHORT;
+		lastStats.indexBytes = shortIndices.size() * sizeof(GLushort);
+	}
+	else
+	{
+		glNamedBufferStorage(indexBuffer, indices.size() * sizeof(GLuint), indices.data(), 0);
+		indexType = GL_UNSIGNED_INT;
+		lastStats.indexBytes = indices.size() * sizeof(GLuint);
+	}
+}
+
+float Terrain::distanceTo(const Chunk &chunk, const glm::vec3 &eye) const
+{
+	glm::vec3 closest = glm::clamp(eye, chunk.bounds.min, chunk.bounds.max);
+	return glm::length(eye - closest);
+}
+
+int Terrain::lodFor(float distance) const
+{
+	int lod = 0;
+	float limit = settings.lodDistance;
+	while (lod + 1 < settings.lodLevels && distance >= limit)
+	{
+		++lod;
+		limit *= 2.0f;
+	}
+	return lod;
+}
+
+void Terrain::update(const glm::vec3 &eye)
+{
+	if (!loaded())
+		return;
+
+	// Evict chunks that left the range (freeing their layers); queue those that came into it,
+	// nearest first.
+	std::vector<std::pair<float, uint32_t>> wanted;
+	std::vector<uint32_t> evictedQueued;
+	for (uint32_t i = 0; i < chunks.size(); ++i)
+	{
+		Chunk &chunk = chunks[i];
+		float distance = distanceTo(chunk, eye);
+		if (chunk.state == ChunkState::UNLOADED && distance <= settings.loadDistance)
+			wanted.push_back({distance, i});
+		else if (chunk.state == ChunkState::RESIDENT && distance > settings.unloadDistance)
+			evict(chunk);
+		else if (chunk.state == ChunkState::QUEUED && distance > settings.unloadDistance)
+			evictedQueued.push_back(i);
+	}
+	std::sort(wanted.begin(), wanted.end());
+
+	// Upload a few finished tiles; drop those that went out of range while being cut.
+	std::vector<BuiltTile> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t take = std::min(built.size(), static_cast<size_t>(std::max(settings.uploadsPerFrame, 1)));
+		std::move(built.begin(), built.begin() + take, std::back_inserter(ready));
+		built.erase(built.begin(), built.begin() + take);
+
+		for (uint32_t i : evictedQueued)
+		{
+			// Only requests the loader has not started can be withdrawn.
+			auto it = std::find(requests.begin(), requests.end(), i);
+			if (it != requests.end())
+			{
+				requests.erase(it);
+				chunks[i].state = ChunkState::UNLOADED;
+			}
+		}
+		for (const auto &request : wanted)
+		{
+			requests.push_back(request.second);
+			chunks[request.second].state = ChunkState::QUEUED;
+		}
+	}
+	if (!wanted.empty())
+		wake.notify_one();
+
+	for (const BuiltTile &tile : ready)
+	{
+		Chunk &chunk = chunks[tile.index];
+		if (chunk.state != ChunkState::QUEUED)
+			continue;
+		float distance = distanceTo(chunk, eye);
+		if (distance > settings.unloadDistance)
+		{
+			chunk.state = ChunkState::UNLOADED;
+			continue;
+		}
+		if (freeLayers.empty())
+		{
+			// The atlas holds everything within unloadDistance, so this only happens when chunks
+			// linger between the two distances: make room by evicting the farthest of them.
+			Chunk *farthest = nullptr;
+			float farthestDistance = std::max(distance, settings.loadDistance);
+			for (Chunk &other : chunks)
+			{
+				if (other.state != ChunkState::RESIDENT)
+					continue;
+				float otherDistance = distanceTo(other, eye);
+				if (otherDistance > farthestDistance)
+				{
+					farthest = &other;
+					farthestDistance = otherDistance;
+				}
+			}
+			if (!farthest)
+			{
+				chunk.state = ChunkState::UNLOADED; // Requested again next frame.
+				continue;
+			}
+			evict(*farthest);
+		}
+		int layer = freeLayers.back();
+		freeLayers.pop_back();
+		uploadTile(tile, layer);
+	}
+
+	lastStats.residentChunks = lastStats.pendingChunks = 0;
+	for (const Chunk &chunk : chunks)
+	{
+		lastStats.residentChunks += chunk.state == ChunkState::RESIDENT;
+		lastStats.pendingChunks += chunk.state == ChunkState::QUEUED;
+	}
+}
+
+std::vector<uint16_t> Terrain::buildTile(uint32_t index) const
+{
+	// The chunk's samples plus a one-sample margin for the normals' central differences; past the
+	// map edge the border samples repeat.
+	const int quads = settings.chunkQuads;
+	const int x0 = static_cast<int>(index % chunksX) * quads - 1;
+	const int z0 = static_cast<int>(index / chunksX) * quads - 1;
+	std::vector<uint16_t> tile(static_cast<size_t>(tileSide) * tileSide);
+	for (int tz = 0; tz < tileSide; ++tz)
+	{
+		const uint16_t *row = heights.samples.data() + static_cast<size_t>(std::clamp(z0 + tz, 0, rows - 1)) * columns;
+		for (int tx = 0; tx < tileSide; ++tx)
+			tile[static_cast<size_t>(tz) * tileSide + tx] = row[std::clamp(x0 + tx, 0, columns - 1)];
+	}
+	return tile;
+}
+
+void Terrain::uploadTile(const BuiltTile &tile, int layer)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTextureSubImage3D(tileAtlas, 0, 0, 0, layer, tileSide, tileSide, 1, GL_RED, GL_UNSIGNED_SHORT, tile.samples.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	chunks[tile.index].state = ChunkState::RESIDENT;
+	chunks[tile.index].layer = layer;
+}
+
+void Terrain::evict(Chunk &chunk)
+{
+	freeLayers.push_back(chunk.layer);
+	chunk.layer = -1;
+	chunk.state = ChunkState::UNLOADED;
+}
+
+void Terrain::loaderLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake.wait(lock, [this]
+				  { return stopping || !requests.empty(); });
+		if (stopping)
+			return;
+		uint32_t index = requests.front();
+		requests.pop_front();
+
+		// The quantized store is never written after load(), so it is read without the lock.
+		lock.unlock();
+		std::vector<uint16_t> samples = buildTile(index);
+		lock.lock();
+		built.push_back({index, std::move(samples)});
+	}
+}
+
+void Terrain::draw(const Frustum &frustum, const glm::vec3 &eye)
+{
+	lastStats.chunksDrawn = lastStats.chunksCulled = lastStats.trianglesDrawn = 0;
+	if (!loaded() || lastStats.residentChunks == 0)
+		return;
+
+	shader.activate();
+	shader.setUniform(modelUniform, glm::translate(glm::mat4(1.0f), origin));
+	MaterialBuffer::instance().bind(materialIndex);
+	if (texture)
+	{
+		texture->bind();
+		shader.setUniform(samplerUniform, static_cast<int>(kTextureUnit));
+	}
+	shader.setUniform(textureLayerUniform, texture ? texture->layer : -1);
+	glBindTextureUnit(1, tileAtlas);
+	glBindVertexArray(vao);
+
+	const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	const int quads = settings.chunkQuads;
+	for (uint32_t i = 0; i < chunks.size(); ++i)
+	{
+		const Chunk &chunk = chunks[i];
+		if (chunk.state != ChunkState::RESIDENT)
+			continue;
+		float distance = distanceTo(chunk, eye);
+		if (distance > settings.loadDistance)
+			continue;
+		AABB bounds = chunk.bounds;
+		bounds.min.y -= heightScale + spacing; // Skirts.
+		if (frustum.test(bounds) == Frustum::OUTSIDE)
+		{
+			++lastStats.chunksCulled;
+			continue;
+		}
+		int lod = lodFor(distance);
+		shader.setUniform(chunkBaseUniform, glm::ivec2(static_cast<int>(i % chunksX) * quads, static_cast<int>(i / chunksX) * quads));
+		shader.setUniform(tileLayerUniform, chunk.layer);
+		glDrawElements(GL_TRIANGLES, lodCount[lod], indexType,
+					   reinterpret_cast<const void *>(lodFirst[lod] * indexSize));
+		++lastStats.chunksDrawn;
+		lastStats.trianglesDrawn += lodCount[lod] / 3;
+	}
+}
+
+void Terrain::clear()
+{
+	if (loader.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		loader.join();
+	}
+	requests.clear();
+	built.clear();
+
+	chunks.clear();
+	freeLayers.clear();
+	if (tileAtlas != 0)
+	{
+		glDeleteTextures(1, &tileAtlas);
+		tileAtlas = 0;
+	}
+	if (indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &indexBuffer);
+		indexBuffer = 0;
+	}
+	if (vao != 0)
+	{
+		glDeleteVertexArrays(1, &vao);
+		vao = 0;
+	}
+	texture.reset();
+	heights = QuantizedHeightmap();
+	columns = rows = chunksX = chunksZ = tileSide = 0;
+	lastStats = Stats();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "AssetManager.hpp"
+#include "Heightmap.hpp"
+#include "ShaderProgram.hpp"
+#include "SceneBVH.hpp"
+
+// Heightmap terrain of any size, split into square chunks that are streamed around the camera.
+//
+// Heights are kept on the CPU as quantized 16-bit samples (see QuantizedHeightmap). On the GPU
+// only chunks near the eye are resident, each as one layer of an R16 texture array (the tile
+// atlas) holding the chunk's samples plus a one-sample margin for the normals. A background
+// thread cuts the tiles of chunks that come within loadDistance out of the store; update()
+// copies a few finished tiles per frame into free layers and frees the layers of chunks beyond
+// unloadDistance, so the atlas has a fixed size however large the map is.
+//
+// There are no vertex buffers: the vertex shader (resources/terrain.vert) turns gl_VertexID into
+// a sample of the chunk, fetches its height from the chunk's layer and derives the normal from
+// the neighbouring samples. All chunks share one index buffer holding the triangles of every LOD
+// level (every 2^lod-th vertex); each chunk picks its level from the distance to the eye, and
+// vertical skirts along the chunk borders hide the cracks between levels.
+class Terrain
+{
+public:
+    struct Settings
+    {
+        int chunkQuads = 64;         // Quads per chunk side at LOD 0 (a power of two).
+        int lodLevels = 4;           // Level l draws every 2^l-th vertex.
+        float lodDistance = 32.0f;   // Distance where LOD 1 starts; each further level doubles it.
+        float loadDistance = 256.0f; // Chunks closer than this are made resident...
+        float unloadDistance = 320.0f; // ...and evicted once they are farther than this.
+        int uploadsPerFrame = 4;     // Finished tiles copied into the atlas per update().
+        float textureRepeat = 1.0f;  // Texture repeats across the whole terrain.
+    };
+
+    // Residency and drawing statistics (drawing fields are for the last draw()).
+    struct Stats
+    {
+        size_t totalChunks = 0;
+        size_t residentChunks = 0; // Tile in the atlas.
+        size_t pendingChunks = 0;  // Queued or being cut by the loader thread.
+        size_t sourceBytes = 0;    // Quantized heights kept on the CPU.
+        size_t textureBytes = 0;   // Tile atlas (all layers, resident or not).
+        size_t indexBytes = 0;     // Shared LOD index buffer.
+        size_t chunksDrawn = 0;
+        size_t chunksCulled = 0;
+        size_t trianglesDrawn = 0;
+
+        size_t residentBytes() const { return sourceBytes + textureBytes + indexBytes; }
+    };
+
+    Settings settings;
+    glm::vec3 origin{0.0f};  // World position of the terrain center at height 0.
+    float spacing = 1.0f;    // World distance between samples.
+    float heightScale = 1.0f; // World height of a white sample.
+
+    Terrain() = default;
+    Terrain(const Terrain &) = delete;
+    Terrain &operator=(const Terrain &) = delete;
+    ~Terrain() { clear(); }
+
+    // Loads an 8- or 16-bit heightmap (resized to width x depth samples if both are given) and
+    // creates the GL objects; shader must use resources/terrain.vert. Throws if the tile atlas
+    // exceeds the driver's texture limits. Tiles are made resident later, on demand, by update().
+    void load(const std::string &heightmapPath, const std::string &texturePath, const ShaderProgram &shader,
+              int width = 0, int depth = 0);
+
+    bool loaded() const { return columns > 0; }
+
+    // True if (x, z) lies over the terrain.
+    bool contains(float worldX, float worldZ) const;
+
+    // Bilinear terrain height at a world position (thread-safe; the samples never change).
+    float heightAt(float worldX, float worldZ) const;
+
+    // Queues chunks that came into range, evicts those out of range, uploads finished tiles.
+    void update(const glm::vec3 &eye);
+
+    // Draws the resident chunks in range and inside the frustum, each at its LOD level.
+    void draw(const Frustum &frustum, const glm::vec3 &eye);
+
+    const Stats &stats() const { return lastStats; }
+
+    // Stops the loader thread, releases the heights and the GL objects (call while the context is alive).
+    void clear();
+
+private:
+    enum class ChunkState : uint8_t
+    {
+        UNLOADED,
+        QUEUED,   // Waiting for or being cut by the loader thread.
+        RESIDENT  // Tile in atlas layer `layer`.
+    };
+
+    struct Chunk
+    {
+        ChunkState state = ChunkState::UNLOADED;
+        int layer = -1;
+        AABB bounds; // World space, skirts excluded.
+    };
+
+    // A tile cut by the loader thread, waiting for upload.
+    struct BuiltTile
+    {
+        uint32_t index;
+        std::vector<uint16_t> samples; // tileSide x tileSide.
+    };
+
+    QuantizedHeightmap heights;
+    int columns = 0;
+    int rows = 0;
+    int chunksX = 0;
+    int chunksZ = 0;
+    std::vector<Chunk> chunks;
+
+    ShaderProgram shader;
+    UniformHandle modelUniform, samplerUniform, textureLayerUniform;
+    UniformHandle chunkBaseUniform, chunkQuadsUniform, gridSizeUniform, spacingUniform;
+    UniformHandle heightOffsetUniform, heightRangeUniform, skirtDepthUniform, texScaleUniform, tileLayerUniform;
+    TextureHandle texture;
+    GLuint materialIndex = 0;
+    GLuint tileAtlas = 0;        // R16 texture array, one chunk tile per layer.
+    int tileSide = 0;            // chunkQuads + 1 samples plus a margin on each side.
+    std::vector<int> freeLayers;
+    GLuint vao = 0; // No attributes, only the index buffer.
+    GLuint indexBuffer = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    std::vector<GLsizei> lodFirst, lodCount; // Index range of each LOD level in indexBuffer.
+
+    // Loader thread and its queues (guarded by mutex).
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> requests;
+    std::vector<BuiltTile> built;
+    bool stopping = false;
+
+    Stats lastStats;
+
+    size_t verticesPerChunk() const;
+    float sample(int x, int z) const; // Height above origin, coordinates clamped.
+    float distanceTo(const Chunk &chunk, const glm::vec3 &eye) const;
+    int lodFor(float distance) const;
+
+    void buildIndices();
+    void computeBounds();
+    void createAtlas();
+    std::vector<uint16_t> buildTile(uint32_t index) const;
+    void uploadTile(const BuiltTile &tile, int layer);
+    void evict(Chunk &chunk);
+    void loaderLoop();
+};
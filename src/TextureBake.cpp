@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+#include "MappedFile.hpp"
+#include "TextureBake.hpp"
+
+const std::filesystem::path kTextureCacheDirectory = "cache/textures";
+
+namespace
+{
+	uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t hashPath(const std::filesystem::path &source)
+	{
+		std::string key = source.lexically_normal().generic_string();
+		return fnv1a(key.data(), key.size());
+	}
+
+	int64_t mtimeOf(const std::filesystem::path &path)
+	{
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	// One mip level of RGBA8 texels, bottom row first.
+	struct Image
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<uint8_t> texels;
+
+		const uint8_t *at(int x, int y) const
+		{
+			x = std::min(x, width - 1);
+			y = std::min(y, height - 1);
+			return texels.data() + (static_cast<size_t>(y) * width + x) * 4;
+		}
+	};
+
+	// 2x2 box filter (the edge texel is repeated for odd sizes), like glGenerateMipmap.
+	Image downsample(const Image &source)
+	{
+		Image level;
+		level.width = std::max(source.width / 2, 1);
+		level.height = std::max(source.height / 2, 1);
+		level.texels.resize(static_cast<size_t>(level.width) * level.height * 4);
+		uint8_t *out = level.texels.data();
+		for (int y = 0; y < level.height; ++y)
+		{
+			for (int x = 0; x < level.width; ++x, out += 4)
+			{
+				const uint8_t *a = source.at(2 * x, 2 * y), *b = source.at(2 * x + 1, 2 * y);
+				const uint8_t *c = source.at(2 * x, 2 * y + 1), *d = source.at(2 * x + 1, 2 * y + 1);
+				for (int channel = 0; channel < 4; ++channel)
+					out[channel] = static_cast<uint8_t>((a[channel] + b[channel] + c[channel] + d[channel] + 2) / 4);
+			}
+		}
+		return level;
+	}
+
+	std::vector<uint8_t> encodeLevel(const Image &level, TextureFileFormat format)
+	{
+		if (format == TextureFileFormat::RGBA8)
+			return level.texels;
+
+		const int blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+		const size_t blockBytes = format == TextureFileFormat::BC1 ? 8 : 16;
+		std::vector<uint8_t> out(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+		uint8_t block[64];
+		for (int by = 0; by < blocksY; ++by)
+		{
+			for (int bx = 0; bx < blocksX; ++bx)
+			{
+				// Texels past the edge repeat the last row / column.
+				for (int y = 0; y < 4; ++y)
+					for (int x = 0; x < 4; ++x)
+						std::memcpy(block + (y * 4 + x) * 4, level.at(bx * 4 + x, by * 4 + y), 4);
+				uint8_t *target = out.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+				if (format == TextureFileFormat::BC1)
+					encodeBC1Block(block, target);
+				else
+					encodeBC3Block(block, target);
+			}
+		}
+		return out;
+	}
+
+	uint16_t to565(const float color[3])
+	{
+		auto channel = [](float value, int max)
+		{ return static_cast<uint16_t>(std::clamp(static_cast<int>(value / 255.0f * max + 0.5f), 0, max)); };
+		return static_cast<uint16_t>((channel(color[0], 31) << 11) | (channel(color[1], 63) << 5) | channel(color[2], 31));
+	}
+
+	void from565(uint16_t packed, int color[3])
+	{
+		int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+}
+
+std::filesystem::path bakedTexturePath(const std::filesystem::path &source, const std::filesystem::path &cacheDir)
+{
+	std::ostringstream name;
+	name << source.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << hashPath(source) << ".pgtex";
+	return cacheDir / name.str();
+}
+
+void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8])
+{
+	// Endpoints: the extremes of the texels along their principal axis (a few power iterations
+	// on the covariance matrix), which keeps gradients in any direction intact.
+	float mean[3] = {};
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 3; ++c)
+			mean[c] += rgba[i * 4 + c] / 16.0f;
+	float cov[6] = {}; // rr, rg, rb, gg, gb, bb
+	for (int i = 0; i < 16; ++i)
+	{
+		float r = rgba[i * 4] - mean[0], g = rgba[i * 4 + 1] - mean[1], b = rgba[i * 4 + 2] - mean[2];
+		cov[0] += r * r, cov[1] += r * g, cov[2] += r * b, cov[3] += g * g, cov[4] += g * b, cov[5] += b * b;
+	}
+	float axis[3] = {1.0f, 1.0f, 1.0f};
+	for (int iteration = 0; iteration < 4; ++iteration)
+	{
+		float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+						 cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+						 cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+		float length = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+		if (length < 1e-6f)
+			break; // Flat block: any axis works.
+		for (int c = 0; c < 3; ++c)
+			axis[c] = next[c] / length;
+	}
+	float lo = 1e30f, hi = -1e30f;
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+		lo = std::min(lo, t);
+		hi = std::max(hi, t);
+	}
+	float axisLengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float end0[3], end1[3];
+	for (int c = 0; c < 3; ++c)
+	{
+		end0[c] = mean[c] + axis[c] * hi / axisLengthSq;
+		end1[c] = mean[c] + axis[c] * lo / axisLengthSq;
+	}
+
+	// Four-color mode needs color0 > color1.
+	uint16_t color0 = to565(end0), color1 = to565(end1);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	int palette[4][3];
+	from565(color0, palette[0]);
+	from565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0, bestError = 1 << 30;
+			for (int p = 0; p < 4; ++p)
+			{
+				int dr = rgba[i * 4] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < bestError)
+					best = p, bestError = error;
+			}
+			indices |= static_cast<uint32_t>(best) << (2 * i);
+		}
+	}
+
+	out[0] = static_cast<uint8_t>(color0), out[1] = static_cast<uint8_t>(color0 >> 8);
+	out[2] = static_cast<uint8_t>(color1), out[3] = static_cast<uint8_t>(color1 >> 8);
+	for (int b = 0; b < 4; ++b)
+		out[4 + b] = static_cast<uint8_t>(indices >> (8 * b));
+}
+
+void encodeBC3Block(const uint8_t rgba[64], uint8_t out[16])
+{
+	// Alpha: eight-value ramp between the block's largest and smallest alpha.
+	int alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; ++i)
+	{
+		alpha0 = std::max<int>(alpha0, rgba[i * 4 + 3]);
+		alpha1 = std::min<int>(alpha1, rgba[i * 4 + 3]);
+	}
+	int ramp[8] = {alpha0, alpha1};
+	for (int k = 1; k <= 6; ++k)
+		ramp[k + 1] = ((7 - k) * alpha0 + k * alpha1) / 7;
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0, bestError = 1 << 30;
+			for (int p = 0; p < 8; ++p)
+			{
+				int error = std::abs(rgba[i * 4 + 3] - ramp[p]);
+				if (error < bestError)
+					best = p, bestError = error;
+			}
+			indices |= static_cast<uint64_t>(best) << (3 * i);
+		}
+	}
+	out[0] = static_cast<uint8_t>(alpha0);
+	out[1] = static_cast<uint8_t>(alpha1);
+	for (int b = 0; b < 6; ++b)
+		out[2 + b] = static_cast<uint8_t>(indices >> (8 * b));
+
+	// Color: a BC1 block (always decoded in four-color mode here).
+	encodeBC1Block(rgba, out + 8);
+}
+
+bool bakeTexture(const std::filesystem::path &source, const std::filesystem::path &target, TextureFileFormat format,
+				 bool automatic)
+{
+	// Decode to RGBA8, bottom row first.
+	cv::Mat image = cv::imread(source.string(), cv::IMREAD_UNCHANGED);
+	if (image.empty())
+	{
+		std::cerr << "Error: Failed to load texture: " << source << "\n";
+		return false;
+	}
+	if (image.depth() == CV_16U)
+		image.convertTo(image, CV_8U, 1.0 / 257.0);
+	if (image.channels() == 1)
+		cv::cvtColor(image, image, cv::COLOR_GRAY2BGRA);
+	else if (image.channels() == 3)
+		cv::cvtColor(image, image, cv::COLOR_BGR2RGBA);
+	else
+		cv::cvtColor(image, image, cv::COLOR_BGRA2RGBA);
+	cv::flip(image, image, 0);
+	if (!image.isContinuous())
+		image = image.clone();
+
+	Image level;
+	level.width = image.cols;
+	level.height = image.rows;
+	level.texels.assign(image.ptr<uint8_t>(0), image.ptr<uint8_t>(0) + image.total() * 4);
+
+	if (automatic)
+	{
+		bool opaque = true;
+		for (size_t i = 3; i < level.texels.size() && opaque; i += 4)
+			opaque = level.texels[i] == 255;
+		format = opaque ? TextureFileFormat::BC1 : TextureFileFormat::BC3;
+	}
+
+	TextureFileHeader header{};
+	std::memcpy(header.magic, "PGTX", 4);
+	header.version = kTextureFileVersion;
+	header.format = format;
+	std::error_code ec;
+	header.sourceSize = std::filesystem::file_size(source, ec);
+	header.sourceMtime = mtimeOf(source);
+	header.pathHash = hashPath(source);
+	MappedFile sourceFile;
+	if (ec || !sourceFile.open(source))
+		return false;
+	header.sourceHash = fnv1a(sourceFile.data(), sourceFile.size());
+
+	// Full chain down to 1x1.
+	std::vector<char> file(sizeof(TextureFileHeader));
+	while (header.levelCount < kMaxTextureLevels)
+	{
+		std::vector<uint8_t> encoded = encodeLevel(level, format);
+		header.levels[header.levelCount++] = {static_cast<uint32_t>(level.width), static_cast<uint32_t>(level.height),
+											  file.size(), encoded.size()};
+		file.insert(file.end(), encoded.begin(), encoded.end());
+		if (level.width == 1 && level.height == 1)
+			break;
+		level = downsample(level);
+	}
+	std::memcpy(file.data(), &header, sizeof(TextureFileHeader));
+
+	if (target.has_parent_path())
+		std::filesystem::create_directories(target.parent_path(), ec);
+	std::filesystem::path temp = target;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		out.write(file.data(), static_cast<std::streamsize>(file.size()));
+		if (!out)
+		{
+			std::cerr << "Error: Failed to write " << target << "\n";
+			return false;
+		}
+	}
+	std::filesystem::rename(temp, target, ec);
+	if (ec)
+	{
+		std::filesystem::remove(temp, ec);
+		std::cerr << "Error: Failed to write " << target << "\n";
+		return false;
+	}
+
+	static const char *formatNames[] = {"RGBA8", "BC1", "BC3"};
+	size_t rawBytes = static_cast<size_t>(image.cols) * image.rows * 4 * 4 / 3;
+	std::cout << "Texture bake: " << source.filename().string() << " " << image.cols << "x" << image.rows << ", "
+			  << header.levelCount << " levels, " << formatNames[static_cast<uint32_t>(format)] << ", "
+			  << (file.size() - sizeof(TextureFileHeader)) / 1024 << " KiB (RGBA8 with mips: " << rawBytes / 1024 << " KiB)\n";
+	return true;
+}
+
+const TextureFileHeader *attachBakedTexture(const std::vector<char> &data)
+{
+	if (data.size() < sizeof(TextureFileHeader))
+		return nullptr;
+	const TextureFileHeader *header = reinterpret_cast<const TextureFileHeader *>(data.data());
+	if (std::memcmp(header->magic, "PGTX", 4) != 0 || header->version != kTextureFileVersion ||
+		header->format > TextureFileFormat::BC3 || header->levelCount == 0 || header->levelCount > kMaxTextureLevels)
+		return nullptr;
+
+	const size_t blockBytes = header->format == TextureFileFormat::BC1 ? 8 : 16;
+	for (uint32_t i = 0; i < header->levelCount; ++i)
+	{
+		const TextureFileLevel &level = header->levels[i];
+		uint64_t expected = header->format == TextureFileFormat::RGBA8
+								? uint64_t(level.width) * level.height * 4
+								: uint64_t((level.width + 3) / 4) * ((level.height + 3) / 4) * blockBytes;
+		if (level.width == 0 || level.height == 0 || level.size != expected || level.offset > data.size() ||
+			level.size > data.size() - level.offset)
+			return nullptr;
+	}
+	return header;
+}
+
+bool loadBakedTexture(const std::filesystem::path &source, std::vector<char> &data, const std::filesystem::path &cacheDir)
+{
+	MappedFile file;
+	if (!file.open(bakedTexturePath(source, cacheDir)) || file.size() < sizeof(TextureFileHeader))
+		return false;
+
+	TextureFileHeader header;
+	std::memcpy(&header, file.data(), sizeof(TextureFileHeader));
+	std::error_code ec;
+	uint64_t sourceSize = std::filesystem::file_size(source, ec);
+	if (ec || header.pathHash != hashPath(source) || header.sourceSize != sourceSize)
+		return false;
+	if (header.sourceMtime != mtimeOf(source))
+	{
+		// Touched but possibly unchanged (e.g. a fresh checkout): compare contents.
+		MappedFile sourceFile;
+		if (!sourceFile.open(source) || fnv1a(sourceFile.data(), sourceFile.size()) != header.sourceHash)
+			return false;
+	}
+
+	data.assign(file.begin(), file.end());
+	return attachBakedTexture(data) != nullptr;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Baked textures: an image with its whole mip chain precomputed offline (pg2_texbake), stored as
+// "<name>-<hash>.pgtex" in the texture cache directory and uploaded level by level with no
+// decoding or mip generation at load time:
+//
+//   [TextureFileHeader][level 0 data][level 1 data]...
+//
+// Rows run bottom to top (OpenGL's origin), so the levels go to the GPU as they are. BC1 and
+// BC3 levels are 4x4 blocks, RGBA8 levels plain texels. An entry is used while the source
+// image's path, size and mtime (or, after a touch, its contents) still match; otherwise the
+// loader falls back to decoding the image.
+
+constexpr uint32_t kTextureFileVersion = 1;
+constexpr uint32_t kMaxTextureLevels = 16;
+
+enum class TextureFileFormat : uint32_t
+{
+    RGBA8 = 0,
+    BC1 = 1, // RGB, 8 bytes per 4x4 block (GL_COMPRESSED_RGB_S3TC_DXT1_EXT).
+    BC3 = 2  // RGBA, 16 bytes per 4x4 block (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT).
+};
+
+struct TextureFileLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset; // From the start of the file.
+    uint64_t size;   // Bytes.
+};
+
+struct TextureFileHeader
+{
+    char magic[4];         // "PGTX".
+    uint32_t version;      // kTextureFileVersion.
+    TextureFileFormat format;
+    uint32_t levelCount;   // 1..kMaxTextureLevels.
+    uint64_t sourceSize;   // Size of the source image in bytes.
+    int64_t sourceMtime;   // Source last_write_time (filesystem clock ticks).
+    uint64_t sourceHash;   // FNV-1a of the source contents.
+    uint64_t pathHash;     // FNV-1a of the source path.
+    TextureFileLevel levels[kMaxTextureLevels];
+};
+static_assert(sizeof(TextureFileHeader) == 432, "TextureFileHeader layout changed; bump kTextureFileVersion");
+
+// Default directory for baked textures, relative to the working directory.
+extern const std::filesystem::path kTextureCacheDirectory;
+
+// Location of the baked entry for a source image.
+std::filesystem::path bakedTexturePath(const std::filesystem::path &source,
+                                       const std::filesystem::path &cacheDir = kTextureCacheDirectory);
+
+// Decodes an image, builds its box-filtered mip chain, encodes it and writes a .pgtex file.
+// automatic picks BC1 for opaque images and BC3 for images with alpha instead of format.
+bool bakeTexture(const std::filesystem::path &source, const std::filesystem::path &target, TextureFileFormat format,
+                 bool automatic = false);
+
+// Reads the baked entry of a source image into data if it exists, is valid and is up to date.
+bool loadBakedTexture(const std::filesystem::path &source, std::vector<char> &data,
+                      const std::filesystem::path &cacheDir = kTextureCacheDirectory);
+
+// Validates a complete .pgtex file image; returns its header or nullptr.
+const TextureFileHeader *attachBakedTexture(const std::vector<char> &data);
+
+// BC1 / BC3 encoding of one 4x4 block of RGBA8 texels (row-major, 16 texels).
+void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8]);
+void encodeBC3Block(const uint8_t rgba[64], uint8_t out[16]);
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "TextureBake.hpp"
+#include "TextureStreamer.hpp"
+
+static double secondsNow()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TextureStreamer::start()
+{
+	slotBytes = std::max<size_t>(settings.uploadBudget, 4096);
+	glCreateBuffers(1, &ring);
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(ring, slotBytes * kRingSlots, nullptr, flags);
+	ringData = static_cast<unsigned char *>(glMapNamedBufferRange(ring, 0, slotBytes * kRingSlots, flags));
+	if (!ringData)
+	{
+		std::cerr << "Error: Failed to map the texture upload buffer\n";
+		throw std::runtime_error("Texture upload buffer mapping failed");
+	}
+
+	// Leave a core for the GL thread.
+	int count = settings.threads > 0 ? settings.threads
+									 : std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1, 4);
+	stopping = false;
+	for (int i = 0; i < count; ++i)
+		workers.emplace_back(&TextureStreamer::workerLoop, this);
+}
+
+void TextureStreamer::request(const std::string &path, const TextureParams &params, const TextureHandle &texture)
+{
+	if (workers.empty())
+	{
+		start();
+		lastStats.firstRequestTime = secondsNow();
+	}
+	++lastStats.requested;
+
+	std::shared_ptr<Job> &job = jobs[path];
+	if (!job)
+	{
+		job = std::make_shared<Job>();
+		job->path = path;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decodeQueue.push_back(job);
+		}
+		wake.notify_one();
+	}
+	job->targets.push_back({texture, params});
+}
+
+void TextureStreamer::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake.wait(lock, [this]
+				  { return stopping || !decodeQueue.empty(); });
+		if (stopping)
+			return;
+		std::shared_ptr<Job> job = decodeQueue.front();
+		decodeQueue.pop_front();
+		lock.unlock();
+
+		if (!readBaked(*job))
+			decode(*job);
+
+		lock.lock();
+		decoded.push_back(job);
+	}
+}
+
+bool TextureStreamer::readBaked(Job &job)
+{
+	if (!loadBakedTexture(job.path, job.baked))
+		return false;
+	const TextureFileHeader *header = attachBakedTexture(job.baked);
+	if (header->format != TextureFileFormat::RGBA8 && !GLEW_EXT_texture_compression_s3tc)
+	{
+		job.baked.clear();
+		return false; // Decode the image instead.
+	}
+
+	size_t first = header->levels[0].offset;
+	for (uint32_t i = 0; i < header->levelCount; ++i)
+	{
+		const TextureFileLevel &level = header->levels[i];
+		job.levels.push_back({static_cast<int>(level.width), static_cast<int>(level.height),
+							  static_cast<size_t>(level.offset - first), static_cast<size_t>(level.size)});
+	}
+	job.data = reinterpret_cast<const unsigned char *>(job.baked.data()) + first;
+	job.bytes = job.baked.size() - first;
+	job.generateMipmaps = false;
+	switch (header->format)
+	{
+	case TextureFileFormat::BC1:
+		job.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		job.pixelFormat = 0;
+		break;
+	case TextureFileFormat::BC3:
+		job.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		job.pixelFormat = 0;
+		break;
+	default:
+		job.internalFormat = GL_RGBA8;
+		job.pixelFormat = GL_RGBA;
+		break;
+	}
+	return true;
+}
+
+void TextureStreamer::decode(Job &job)
+{
+	// Decode to 8-bit BGR or BGRA, flipped to OpenGL's bottom-left origin.
+	cv::Mat image = cv::imread(job.path, cv::IMREAD_UNCHANGED);
+	if (image.empty())
+		return;
+	if (image.depth() == CV_16U)
+		image.convertTo(image, CV_8U, 1.0 / 257.0);
+	if (image.channels() == 1)
+		cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+	cv::flip(image, image, 0);
+	if (!image.isContinuous())
+		image = image.clone();
+
+	const bool alpha = image.channels() == 4;
+	job.image = image;
+	job.data = image.ptr<unsigned char>(0);
+	job.bytes = image.total() * image.elemSize();
+	job.levels = {{image.cols, image.rows, 0, job.bytes}};
+	job.internalFormat = alpha ? GL_RGBA8 : GL_RGB8;
+	job.pixelFormat = alpha ? GL_BGRA : GL_BGR;
+	job.generateMipmaps = true;
+}
+
+bool TextureStreamer::update()
+{
+	if (workers.empty())
+		return false;
+
+	// Next ring slot; wait for the GPU to finish reading what was uploaded from it kRingSlots frames ago.
+	slot = (slot + 1) % kRingSlots;
+	if (fences[slot])
+	{
+		glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		glDeleteSync(fences[slot]);
+		fences[slot] = nullptr;
+	}
+
+	size_t used = 0;
+	size_t handled = 0; // Jobs taken this frame, failed ones included.
+	bool ringUsed = false;
+	while (true)
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty())
+				break;
+			size_t bytes = decoded.front()->bytes;
+			if (used > 0 && used + bytes > slotBytes)
+				break; // Over budget: the rest waits for the next frame.
+			job = decoded.front();
+			decoded.pop_front();
+		}
+		jobs.erase(job->path);
+		++handled;
+
+		if (!job->data)
+		{
+			std::cerr << "Error: Failed to load texture: " << job->path << "\n";
+			lastStats.failed += job->targets.size();
+			continue;
+		}
+
+		size_t bytes = job->bytes;
+		if (bytes <= slotBytes)
+		{
+			GLintptr offset = static_cast<GLintptr>(slot * slotBytes + used);
+			std::memcpy(ringData + offset, job->data, bytes);
+			upload(*job, nullptr, offset);
+			ringUsed = true;
+		}
+		else
+		{
+			// Larger than a ring slot: upload straight from the job's memory (alone in its frame).
+			upload(*job, job->data, 0);
+		}
+		lastStats.baked += job->baked.empty() ? 0 : 1;
+		used += (bytes + 3) & ~size_t(3);
+		lastStats.uploadedBytes += bytes;
+	}
+
+	if (ringUsed)
+		fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (handled == 0 || lastStats.pending() != 0)
+		return false;
+	lastStats.lastUploadTime = secondsNow();
+	std::cout << "Textures: " << lastStats.loaded << " loaded (" << (lastStats.uploadedBytes >> 10) << " KiB, "
+			  << lastStats.baked << " images baked) "
+			  << static_cast<int>((lastStats.lastUploadTime - lastStats.firstRequestTime) * 1000.0)
+			  << " ms after the first request\n";
+	return true;
+}
+
+void TextureStreamer::upload(Job &job, const unsigned char *pixels, GLintptr ringOffset)
+{
+	const Level &base = job.levels.front();
+	const GLsizei levels = job.generateMipmaps
+							   ? 1 + static_cast<GLsizei>(std::floor(std::log2(std::max(base.width, base.height))))
+							   : static_cast<GLsizei>(job.levels.size());
+	auto source = [&](const Level &level)
+	{ return pixels ? static_cast<const void *>(pixels + level.offset)
+					: reinterpret_cast<const void *>(ringOffset + static_cast<GLintptr>(level.offset)); };
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (!pixels)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+	for (const Job::Target &target : job.targets)
+	{
+		++lastStats.loaded;
+		TextureHandle texture = target.texture.lock();
+		if (!texture)
+			continue; // Every holder let go while it was loading.
+
+		GLuint id = 0;
+		glCreateTextures(GL_TEXTURE_2D, 1, &id);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_S, target.params.wrap);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_T, target.params.wrap);
+		glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, target.params.minFilter);
+		glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, target.params.magFilter);
+		glTextureStorage2D(id, levels, job.internalFormat, base.width, base.height);
+		for (size_t i = 0; i < job.levels.size(); ++i)
+		{
+			const Level &level = job.levels[i];
+			if (job.pixelFormat == 0)
+				glCompressedTextureSubImage2D(id, static_cast<GLint>(i), 0, 0, level.width, level.height, job.internalFormat,
+											  static_cast<GLsizei>(level.size), source(level));
+			else
+				glTextureSubImage2D(id, static_cast<GLint>(i), 0, 0, level.width, level.height, job.pixelFormat,
+									GL_UNSIGNED_BYTE, source(level));
+		}
+		if (job.generateMipmaps)
+			glGenerateTextureMipmap(id);
+
+		// Swap the real texture in; draws pick the new name up from the shared resource.
+		texture->id = id;
+		texture->width = base.width;
+		texture->height = base.height;
+		texture->format = job.internalFormat;
+		texture->levels = levels;
+		// Baked data is stored as uploaded; drivers pad RGB8 to four bytes and a mip chain adds a third.
+		texture->bytes = job.generateMipmaps ? static_cast<size_t>(base.width) * base.height * 4 * 4 / 3 : job.bytes;
+		texture->pending = false;
+	}
+	if (!pixels)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureStreamer::clear()
+{
+	if (!workers.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			decodeQueue.clear();
+		}
+		wake.notify_all();
+		for (std::thread &worker : workers)
+			worker.join();
+		workers.clear();
+	}
+	decoded.clear();
+	jobs.clear();
+
+	for (GLsync &fence : fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (ring != 0)
+	{
+		glUnmapNamedBuffer(ring);
+		glDeleteBuffers(1, &ring);
+		ring = 0;
+		ringData = nullptr;
+	}
+	lastStats = Stats();
+}
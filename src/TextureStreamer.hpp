@@ -0,0 +1,125 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <opencv2/opencv.hpp>
+
+#include "AssetManager.hpp"
+
+// Loads image textures without stalling the GL thread.
+//
+// request() returns immediately: the texture keeps the placeholder's GL name until its image
+// is ready. Worker threads read the image's baked .pgtex entry (see TextureBake.hpp) when an
+// up-to-date one exists, or decode and flip the image otherwise (one read per path, however many
+// textures want it); update(), called once per frame on the GL thread, copies the texel data
+// into a persistently mapped pixel buffer ring, uploads it from there into immutable textures
+// (baked levels as they are, compressed or not; decoded images get glGenerateTextureMipmap),
+// and swaps the real names into the waiting TextureResources. Uploads stop for the frame once
+// the byte budget is used, so a burst of large images is spread over frames.
+class TextureStreamer
+{
+public:
+    struct Settings
+    {
+        int threads = 0;                       // Decode workers; 0 picks from the hardware.
+        size_t uploadBudget = 8 * 1024 * 1024; // Bytes uploaded per update() (also the ring slot size).
+    };
+
+    struct Stats
+    {
+        size_t requested = 0; // Textures handed out by request().
+        size_t loaded = 0;    // Textures with their real image.
+        size_t baked = 0;     // Images read from baked entries instead of being decoded.
+        size_t failed = 0;    // Images that could not be decoded (they keep the placeholder).
+        size_t uploadedBytes = 0;
+        double firstRequestTime = 0.0; // Seconds, steady clock.
+        double lastUploadTime = 0.0;
+
+        size_t pending() const { return requested - loaded - failed; }
+    };
+
+    TextureStreamer() = default;
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+    ~TextureStreamer() { clear(); }
+
+    // Applies to the next start (the first request()).
+    Settings settings;
+
+    // Queues the image at path for texture, which must already hold a placeholder name (pending).
+    void request(const std::string &path, const TextureParams &params, const TextureHandle &texture);
+
+    // Uploads decoded images within the budget (GL thread, once per frame). Returns true on the
+    // frame the last pending texture was handled (loaded or failed).
+    bool update();
+
+    const Stats &stats() const { return lastStats; }
+
+    // Stops the workers and releases the ring (call while the context is alive).
+    void clear();
+
+private:
+    struct Level
+    {
+        int width, height;
+        size_t offset, size; // Within the job's data.
+    };
+
+    // One image path and every texture waiting for it.
+    struct Job
+    {
+        std::string path;
+
+        // Written by the worker, read by update() once the job is decoded.
+        cv::Mat image;           // Decoded BGR(A) base level (raw images).
+        std::vector<char> baked; // Whole .pgtex file (baked images).
+        const unsigned char *data = nullptr;
+        size_t bytes = 0;
+        std::vector<Level> levels;
+        GLenum internalFormat = GL_RGB8;
+        GLenum pixelFormat = GL_BGR; // 0 for compressed levels.
+        bool generateMipmaps = true;
+
+        // GL thread only.
+        struct Target
+        {
+            std::weak_ptr<TextureResource> texture;
+            TextureParams params;
+        };
+        std::vector<Target> targets;
+    };
+
+    static constexpr int kRingSlots = 3; // Frames whose uploads may still be in flight.
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Job>> decodeQueue; // Guarded by mutex.
+    std::deque<std::shared_ptr<Job>> decoded;     // Guarded by mutex.
+    bool stopping = false;                        // Guarded by mutex.
+
+    std::unordered_map<std::string, std::shared_ptr<Job>> jobs; // In flight, by path (GL thread only).
+
+    GLuint ring = 0;
+    unsigned char *ringData = nullptr;
+    size_t slotBytes = 0;
+    int slot = 0;
+    GLsync fences[kRingSlots] = {};
+
+    Stats lastStats;
+
+    void start();
+    void workerLoop();
+    static bool readBaked(Job &job);
+    static void decode(Job &job);
+    void upload(Job &job, const unsigned char *pixels, GLintptr ringOffset);
+};
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "UniformBlocks.hpp"
+
+static GLsizeiptr alignUp(GLsizeiptr value, GLsizeiptr alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static GLsizeiptr uniformOffsetAlignment()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return alignment > 0 ? alignment : 256;
+}
+
+void FrameUniformBuffer::create()
+{
+	GLsizeiptr alignment = uniformOffsetAlignment();
+	lightOffset = alignUp(sizeof(CameraData), alignment);
+	regionSize = alignUp(lightOffset + sizeof(LightData), alignment);
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, regionSize * kRegions, nullptr, flags);
+	mapped = static_cast<unsigned char *>(glMapNamedBufferRange(buffer, 0, regionSize * kRegions, flags));
+	if (mapped == nullptr)
+	{
+		std::cerr << "Error: Failed to map the per-frame uniform buffer\n";
+		throw std::runtime_error("Uniform buffer mapping failed");
+	}
+}
+
+void FrameUniformBuffer::update(const CameraData &camera, const LightData &lights)
+{
+	if (buffer == 0)
+		create();
+
+	region = (region + 1) % kRegions;
+	if (fences[region])
+	{
+		// Only blocks when the CPU is kRegions frames ahead of the GPU.
+		while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+
+	GLsizeiptr base = regionSize * region;
+	std::memcpy(mapped + base, &camera, sizeof(CameraData));
+	std::memcpy(mapped + base + lightOffset, &lights, sizeof(LightData));
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, kCameraBlockBinding, buffer, base, sizeof(CameraData));
+	glBindBufferRange(GL_UNIFORM_BUFFER, kLightBlockBinding, buffer, base + lightOffset, sizeof(LightData));
+}
+
+void FrameUniformBuffer::endFrame()
+{
+	if (buffer == 0)
+		return;
+	if (fences[region])
+		glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameUniformBuffer::clear()
+{
+	for (GLsync &fence : fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (buffer != 0)
+	{
+		glUnmapNamedBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	mapped = nullptr;
+}
+
+void ClusterLightBuffer::upload(Storage &storage, GLuint binding, const void *data, size_t bytes)
+{
+	// Grow by doubling; an empty list still gets a valid (unused) buffer to bind.
+	if (storage.buffer == 0 || bytes > storage.capacity)
+	{
+		if (storage.buffer != 0)
+			glDeleteBuffers(1, &storage.buffer);
+		storage.capacity = std::max<size_t>(1024, std::max(bytes, storage.capacity * 2));
+		glCreateBuffers(1, &storage.buffer);
+		glNamedBufferData(storage.buffer, storage.capacity, nullptr, GL_STREAM_DRAW);
+	}
+	else
+	{
+		glInvalidateBufferData(storage.buffer);
+	}
+	if (bytes > 0)
+		glNamedBufferSubData(storage.buffer, 0, bytes, data);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, storage.buffer);
+}
+
+void ClusterLightBuffer::update(const std::vector<ClusterLight> &lights, const LightClusters &clusters)
+{
+	upload(lightStorage, kClusterLightBinding, lights.data(), lights.size() * sizeof(ClusterLight));
+	upload(rangeStorage, kClusterRangeBinding, clusters.ranges().data(), clusters.ranges().size() * sizeof(glm::uvec2));
+	upload(indexStorage, kClusterIndexBinding, clusters.indices().data(), clusters.indices().size() * sizeof(uint32_t));
+}
+
+void ClusterLightBuffer::clear()
+{
+	for (Storage *storage : {&lightStorage, &rangeStorage, &indexStorage})
+	{
+		if (storage->buffer != 0)
+			glDeleteBuffers(1, &storage->buffer);
+		*storage = Storage();
+	}
+}
+
+MaterialBuffer &MaterialBuffer::instance()
+{
+	static MaterialBuffer materialBuffer;
+	return materialBuffer;
+}
+
+GLuint MaterialBuffer::acquire(const MaterialData &material)
+{
+	// Scenes use a handful of materials, so a linear scan is cheaper than hashing.
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		if (materials[i] == material)
+			return static_cast<GLuint>(i);
+	}
+
+	materials.push_back(material);
+	if (buffer != 0 && materials.size() <= capacity)
+	{
+		glNamedBufferSubData(buffer, stride * (materials.size() - 1), sizeof(MaterialData), &material);
+	}
+	else
+	{
+		upload();
+	}
+	return static_cast<GLuint>(materials.size() - 1);
+}
+
+void MaterialBuffer::upload()
+{
+	if (stride == 0)
+		stride = alignUp(sizeof(MaterialData), uniformOffsetAlignment());
+	capacity = std::max<size_t>(16, materials.size() * 2);
+
+	std::vector<unsigned char> staging(stride * capacity, 0);
+	for (size_t i = 0; i < materials.size(); ++i)
+		std::memcpy(staging.data() + stride * i, &materials[i], sizeof(MaterialData));
+
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	glCreateBuffers(1, &buffer);
+	glNamedBufferData(buffer, staging.size(), staging.data(), GL_DYNAMIC_DRAW);
+	boundIndex = ~0u;
+}
+
+void MaterialBuffer::bind(GLuint index)
+{
+	if (index == boundIndex || buffer == 0)
+		return;
+	glBindBufferRange(GL_UNIFORM_BUFFER, kMaterialBlockBinding, buffer, stride * index, sizeof(MaterialData));
+	boundIndex = index;
+}
+
+void MaterialBuffer::clear()
+{
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	capacity = 0;
+	boundIndex = ~0u;
+	materials.clear();
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "LightClusters.hpp"
+
+// C++ mirrors of the std140 uniform blocks declared in basic.vert / basic.frag.
+// Every vec3 is followed by a float so each pair fills one 16-byte std140 slot.
+
+// Uniform buffer binding points shared by all shader programs.
+constexpr GLuint kCameraBlockBinding = 0;   // CameraBlock: view, projection, eye position.
+constexpr GLuint kLightBlockBinding = 1;    // LightBlock: sun, shadow cascades, light cluster parameters.
+constexpr GLuint kMaterialBlockBinding = 2; // MaterialBlock: per-material colors.
+
+// Shader storage binding points of the clustered lights (0 and 1 hold RenderQueue's instance data).
+constexpr GLuint kClusterLightBinding = 2; // ClusterLights: every point and spot light of the frame.
+constexpr GLuint kClusterRangeBinding = 3; // ClusterRanges: {first, count} per cluster.
+constexpr GLuint kClusterIndexBinding = 4; // ClusterIndices: light indices, grouped by cluster.
+
+struct CameraData
+{
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec3 viewPos{0.0f};
+    float pad0{0.0f};
+};
+
+struct DirLightData
+{
+    glm::vec3 direction{0.0f};
+    float pad0{0.0f};
+    glm::vec3 ambient{0.0f};
+    float pad1{0.0f};
+    glm::vec3 diffuse{0.0f};
+    float pad2{0.0f};
+    glm::vec3 specular{0.0f};
+    float pad3{0.0f};
+};
+
+constexpr int kMaxShadowCascades = 4;
+
+// Sun, its shadow cascades (ShadowMaps) and the parameters basic.frag needs to find a
+// fragment's light cluster; the point and spot lights themselves live in ClusterLightBuffer.
+struct LightData
+{
+    DirLightData dirLight;
+    glm::uvec4 clusterGrid{1u, 1u, 1u, 0u}; // Tiles in x, tiles in y, depth slices, lights.
+    glm::vec2 clusterTileSize{1.0f};        // Pixels.
+    float clusterSliceScale{0.0f};          // slice = log(view depth) * scale + bias.
+    float clusterSliceBias{0.0f};
+    glm::mat4 shadowMatrices[kMaxShadowCascades]{}; // World -> shadow map texture coordinates and depth.
+    glm::vec4 cascadeSplits{0.0f};                  // View depth where each cascade ends.
+    glm::vec4 cascadeTexelSizes{0.0f};              // World size of a shadow texel per cascade.
+    int32_t shadowCascades{0};                      // 0 = no shadows.
+    int32_t shadowPcfRadius{1};                     // (2r + 1)^2 filtered taps.
+    float shadowTexelSize{0.0f};                    // 1 / shadow map resolution.
+    float pad0{0.0f};
+};
+
+struct MaterialData
+{
+    glm::vec3 ambient{1.0f};
+    float shininess{1.0f};
+    glm::vec3 diffuse{1.0f};
+    float pad0{0.0f};
+    glm::vec3 specular{1.0f};
+    float pad1{0.0f};
+
+    bool operator==(const MaterialData &other) const
+    {
+        return ambient == other.ambient && shininess == other.shininess &&
+               diffuse == other.diffuse && specular == other.specular;
+    }
+    bool operator!=(const MaterialData &other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(CameraData) == 144, "CameraData must match the std140 CameraBlock");
+static_assert(sizeof(DirLightData) == 64, "DirLightData must match the std140 DirLight");
+static_assert(offsetof(LightData, clusterTileSize) == 80, "LightData must match the std140 LightBlock");
+static_assert(offsetof(LightData, shadowMatrices) == 96, "LightData must match the std140 LightBlock");
+static_assert(offsetof(LightData, shadowCascades) == 384, "LightData must match the std140 LightBlock");
+static_assert(sizeof(LightData) == 400, "LightData must match the std140 LightBlock");
+static_assert(sizeof(MaterialData) == 48, "MaterialData must match the std140 MaterialBlock");
+
+// Camera and light blocks of the current frame. Both live in one persistently mapped
+// buffer split into a ring of regions; each frame writes the next region and a fence
+// keeps the CPU from overwriting a region the GPU is still reading.
+class FrameUniformBuffer
+{
+public:
+    static constexpr int kRegions = 3;
+
+    FrameUniformBuffer() = default;
+    FrameUniformBuffer(const FrameUniformBuffer &) = delete;
+    FrameUniformBuffer &operator=(const FrameUniformBuffer &) = delete;
+    ~FrameUniformBuffer() { clear(); }
+
+    // Writes the frame's data and binds it to kCameraBlockBinding / kLightBlockBinding.
+    void update(const CameraData &camera, const LightData &lights);
+
+    // Marks the end of the draws that read the current region.
+    void endFrame();
+
+    // Releases the buffer (call while the GL context is alive).
+    void clear();
+
+private:
+    GLuint buffer = 0;
+    unsigned char *mapped = nullptr;
+    GLsizeiptr lightOffset = 0; // Offset of LightData inside a region.
+    GLsizeiptr regionSize = 0;
+    int region = kRegions - 1;
+    GLsync fences[kRegions] = {};
+
+    void create();
+};
+
+// Lights and cluster lists of the current frame in three shader storage buffers, re-specified
+// every frame (the driver renames them, so the previous frame's draws keep their copy).
+class ClusterLightBuffer
+{
+public:
+    ClusterLightBuffer() = default;
+    ClusterLightBuffer(const ClusterLightBuffer &) = delete;
+    ClusterLightBuffer &operator=(const ClusterLightBuffer &) = delete;
+    ~ClusterLightBuffer() { clear(); }
+
+    // Uploads the lights and the lists of clusters and binds them to kCluster*Binding.
+    void update(const std::vector<ClusterLight> &lights, const LightClusters &clusters);
+
+    // Releases the buffers (call while the GL context is alive).
+    void clear();
+
+private:
+    struct Storage
+    {
+        GLuint buffer = 0;
+        size_t capacity = 0; // In bytes.
+    };
+    Storage lightStorage, rangeStorage, indexStorage;
+
+    static void upload(Storage &storage, GLuint binding, const void *data, size_t bytes);
+};
+
+// Interns material values into one uniform buffer; meshes bind their entry by index.
+class MaterialBuffer
+{
+public:
+    // Process-wide table, shared by all shader programs.
+    static MaterialBuffer &instance();
+
+    // Returns the index of the material, adding it if it is new.
+    GLuint acquire(const MaterialData &material);
+
+    // Binds entry index to kMaterialBlockBinding (skipped if it is already bound).
+    void bind(GLuint index);
+
+    size_t size() const { return materials.size(); }
+
+    // Releases the buffer (call while the GL context is alive).
+    void clear();
+
+private:
+    MaterialBuffer() = default;
+
+    std::vector<MaterialData> materials;
+    GLuint buffer = 0;
+    size_t capacity = 0;       // In entries.
+    GLsizeiptr stride = 0;     // sizeof(MaterialData) rounded up to the UBO offset alignment.
+    GLuint boundIndex = ~0u;
+
+    void upload();
+};
@@ -6,10 +6,15 @@
 // C++
 // include anywhere, in any order
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iterator>
 #include <stack>
 #include <random>
+#include <sstream>
 #include <string>
 
 // OpenCV (does not depend on GL)
@@ -38,85 +43,238 @@
 #include "assets.hpp"
 #include "ShaderProgram.hpp"
 #include "OBJloader.hpp"
+#include "MeshCache.hpp"
+#include "AssetManager.hpp"
+#include "RenderQueue.hpp"
+#include "FrameProfiler.hpp"
+#include "SceneBVH.hpp"
+#include "Labyrinth.hpp"
+#include "Simulation.hpp"
 #include "Model.hpp"
+#include "TextureStreamer.hpp"
 
 using json = nlohmann::json; // Alias for convenience
 
+// Player start, shared by the windowed and the headless runs
+static const glm::vec3 kPlayerStart(0.0f, 20.0f, -7.0f);
+
+// The flat floor's mesh spans width/2, so keep it well beyond the walls
+static float labyrinthFloorSize(int gridSize, float cubeSize)
+{
+	return std::max(100.0f, 4.0f * gridSize * cubeSize);
+}
+
 App::App()
 {
 	// default constructor
-	// nothing to do here (so far...)
+	// Terrain defaults reproduce the old 50x50 heightmap model, which was drawn at half scale
+	terrain.spacing = 0.5f;
+	terrain.heightScale = 2.5f;
 	std::cout << "Constructed...\n";
 }
 
-bool App::init()
+void App::loadSettings()
 {
-	std::cout << "Starting init...\n";
-	try
+	// Load settings from app_settings.json
+	std::ifstream settingsFile("app_settings.json");
+	if (settingsFile.is_open())
 	{
-		// initialization code
-		//...
-		// init glfw
-		// https://www.glfw.org/documentation.html
-		std::cout << "Initializing GLFW...\n";
-		glfwInit();
+		try
+		{
+			json settings = json::parse(settingsFile);
 
-		glfwSetErrorCallback(error_callback);
+			// Set appname (with fallback)
+			if (settings.contains("appname") && settings["appname"].is_string())
+			{
+				appname = settings["appname"].get<std::string>();
+			}
 
-		// Load settings from app_settings.json
-		std::ifstream settingsFile("app_settings.json");
-		if (settingsFile.is_open())
-		{
-			try
+			// Set default_resolution (with fallback)
+			if (settings.contains("default_resolution") && settings["default_resolution"].is_object())
 			{
-				json settings = json::parse(settingsFile);
+				if (settings["default_resolution"].contains("x") && settings["default_resolution"]["x"].is_number_integer())
+				{
+					resX = settings["default_resolution"]["x"].get<int>();
+				}
+				if (settings["default_resolution"].contains("y") && settings["default_resolution"]["y"].is_number_integer())
+				{
+					resY = settings["default_resolution"]["y"].get<int>();
+				}
+			}
 
-				// Set appname (with fallback)
-				if (settings.contains("appname") && settings["appname"].is_string())
+			// Set antialiasing
+			if (settings.contains("antialiasing") && settings["antialiasing"].is_object())
+			{
+				if (settings["antialiasing"].contains("enabled") && settings["antialiasing"]["enabled"].is_boolean())
+				{
+					antiAliasingEnabled = settings["antialiasing"]["enabled"].get<bool>();
+				}
+				if (settings["antialiasing"].contains("samples") && settings["antialiasing"]["samples"].is_number_integer())
 				{
-					appname = settings["appname"].get<std::string>();
+					antiAliasingSamples = settings["antialiasing"]["samples"].get<int>();
 				}
+				std::cout << "Antialiasing enabled: " << (antiAliasingEnabled ? "true" : "false") << "\n";
+				std::cout << "Antialiasing samples: " << antiAliasingSamples << "\n";
+			}
 
-				// Set default_resolution (with fallback)
-				if (settings.contains("default_resolution") && settings["default_resolution"].is_object())
+			// Load labyrinth size (cells per side)
+			if (settings.contains("labyrinth") && settings["labyrinth"].is_object())
+			{
+				if (settings["labyrinth"].contains("size") && settings["labyrinth"]["size"].is_number_integer())
 				{
-					if (settings["default_resolution"].contains("x") && settings["default_resolution"]["x"].is_number_integer())
-					{
-						resX = settings["default_resolution"]["x"].get<int>();
-					}
-					if (settings["default_resolution"].contains("y") && settings["default_resolution"]["y"].is_number_integer())
-					{
-						resY = settings["default_resolution"]["y"].get<int>();
-					}
+					labyrinthSize = std::max(3, settings["labyrinth"]["size"].get<int>());
 				}
+				std::cout << "Labyrinth size: " << labyrinthSize << "\n";
+			}
 
-				// Set antialiasing
-				if (settings.contains("antialiasing") && settings["antialiasing"].is_object())
+			// Streamed heightmap terrain
+			if (settings.contains("terrain") && settings["terrain"].is_object())
+			{
+				const json &terrainSettings = settings["terrain"];
+				if (terrainSettings.contains("heightmap") && terrainSettings["heightmap"].is_string())
+					terrainHeightmap = terrainSettings["heightmap"].get<std::string>();
+				if (terrainSettings.contains("size") && terrainSettings["size"].is_number_integer())
+					terrainSize = terrainSettings["size"].get<int>();
+				if (terrainSettings.contains("spacing") && terrainSettings["spacing"].is_number())
+					terrain.spacing = terrainSettings["spacing"].get<float>();
+				if (terrainSettings.contains("height_scale") && terrainSettings["height_scale"].is_number())
+					terrain.heightScale = terrainSettings["height_scale"].get<float>();
+				if (terrainSettings.contains("chunk_quads") && terrainSettings["chunk_quads"].is_number_integer())
+					terrain.settings.chunkQuads = std::clamp(terrainSettings["chunk_quads"].get<int>(), 4, 256);
+				if (terrainSettings.contains("lod_distance") && terrainSettings["lod_distance"].is_number())
+					terrain.settings.lodDistance = terrainSettings["lod_distance"].get<float>();
+				if (terrainSettings.contains("load_distance") && terrainSettings["load_distance"].is_number())
 				{
-					if (settings["antialiasing"].contains("enabled") && settings["antialiasing"]["enabled"].is_boolean())
-					{
-						antiAliasingEnabled = settings["antialiasing"]["enabled"].get<bool>();
-					}
-					if (settings["antialiasing"].contains("samples") && settings["antialiasing"]["samples"].is_number_integer())
-					{
-						antiAliasingSamples = settings["antialiasing"]["samples"].get<int>();
-						glfwWindowHint(GLFW_SAMPLES, antiAliasingSamples);
-					}
-					std::cout << "Antialiasing enabled: " << (antiAliasingEnabled ? "true" : "false") << "\n";
-					std::cout << "Antialiasing samples: " << antiAliasingSamples << "\n";
+					terrain.settings.loadDistance = terrainSettings["load_distance"].get<float>();
+					terrain.settings.unloadDistance = terrain.settings.loadDistance * 1.25f;
+				}
+				std::cout << "Terrain: " << terrainHeightmap << " (" << (terrainSize > 0 ? std::to_string(terrainSize) : "native") << ")\n";
+			}
+
+			// Fixed simulation rate (steps per second)
+			if (settings.contains("simulation") && settings["simulation"].is_object())
+			{
+				if (settings["simulation"].contains("rate") && settings["simulation"]["rate"].is_number())
+				{
+					simulationRate = std::clamp(settings["simulation"]["rate"].get<double>(), 10.0, 1000.0);
+				}
+				std::cout << "Simulation rate: " << simulationRate << " Hz\n";
+			}
+
+			// Background texture loading
+			if (settings.contains("textures") && settings["textures"].is_object())
+			{
+				TextureStreamer::Settings &textureSettings = AssetManager::instance().textureStreamer().settings;
+				if (settings["textures"].contains("loader_threads") && settings["textures"]["loader_threads"].is_number_integer())
+				{
+					textureSettings.threads = std::max(0, settings["textures"]["loader_threads"].get<int>());
+				}
+				if (settings["textures"].contains("upload_budget_mb") && settings["textures"]["upload_budget_mb"].is_number())
+				{
+					textureSettings.uploadBudget = static_cast<size_t>(std::max(0.25, settings["textures"]["upload_budget_mb"].get<double>()) * 1024 * 1024);
+				}
+				std::cout << "Texture upload budget: " << (textureSettings.uploadBudget >> 10) << " KiB per frame\n";
+			}
+
+			// Rendering
+			if (settings.contains("render") && settings["render"].is_object())
+			{
+				if (settings["render"].contains("depth_prepass") && settings["render"]["depth_prepass"].is_boolean())
+				{
+					depthPrepassEnabled = settings["render"]["depth_prepass"].get<bool>();
+				}
+				if (settings["render"].contains("transparency") && settings["render"]["transparency"].is_string())
+				{
+					orderIndependentTransparency = settings["render"]["transparency"].get<std::string>() != "sorted";
+				}
+			}
+
+			// Sun shadows
+			if (settings.contains("shadows") && settings["shadows"].is_object())
+			{
+				const json &shadowSettings = settings["shadows"];
+				ShadowMaps::Settings &config = shadowMaps.settings;
+				if (shadowSettings.contains("cascades") && shadowSettings["cascades"].is_number_integer())
+				{
+					config.cascades = std::clamp(shadowSettings["cascades"].get<int>(), 0, kMaxShadowCascades);
+				}
+				if (shadowSettings.contains("resolution") && shadowSettings["resolution"].is_number_integer())
+				{
+					config.resolution = std::clamp(shadowSettings["resolution"].get<int>(), 256, 8192);
+				}
+				if (shadowSettings.contains("distance") && shadowSettings["distance"].is_number())
+				{
+					config.distance = std::max(1.0f, shadowSettings["distance"].get<float>());
+				}
+				if (shadowSettings.contains("pcf_radius") && shadowSettings["pcf_radius"].is_number_integer())
+				{
+					config.pcfRadius = std::clamp(shadowSettings["pcf_radius"].get<int>(), 0, 3);
 				}
 			}
-			catch (const json::exception &e)
+
+#if PG2_PROFILER
+			// Frame profiler: statistics window and per-frame dumps
+			if (settings.contains("profiler") && settings["profiler"].is_object())
 			{
-				std::cerr << "JSON parsing error: " << e.what() << '\n';
-				// Continue with defaults
+				const json &profilerSettings = settings["profiler"];
+				if (profilerSettings.contains("window") && profilerSettings["window"].is_number_integer())
+				{
+					profiler.settings.window = static_cast<size_t>(std::max(1, profilerSettings["window"].get<int>()));
+				}
+				if (profilerSettings.contains("csv") && profilerSettings["csv"].is_string())
+				{
+					profiler.settings.csvPath = profilerSettings["csv"].get<std::string>();
+				}
+				if (profilerSettings.contains("json") && profilerSettings["json"].is_string())
+				{
+					profiler.settings.jsonPath = profilerSettings["json"].get<std::string>();
+				}
+			}
+#endif
+
+			// Light scaling benchmark
+			if (settings.contains("lights") && settings["lights"].is_object())
+			{
+				if (settings["lights"].contains("benchmark") && settings["lights"]["benchmark"].is_boolean())
+				{
+					lightBenchmark.enabled = settings["lights"]["benchmark"].get<bool>();
+				}
+				if (settings["lights"].contains("benchmark_seconds") && settings["lights"]["benchmark_seconds"].is_number())
+				{
+					lightBenchmark.secondsPerStep = std::max(0.5, settings["lights"]["benchmark_seconds"].get<double>());
+				}
 			}
-			settingsFile.close();
 		}
-		else
+		catch (const json::exception &e)
 		{
-			std::cerr << "Could not open app_settings.json, using defaults\n";
+			std::cerr << "JSON parsing error: " << e.what() << '\n';
+			// Continue with defaults
 		}
+		settingsFile.close();
+	}
+	else
+	{
+		std::cerr << "Could not open app_settings.json, using defaults\n";
+	}
+}
+
+bool App::init()
+{
+	std::cout << "Starting init...\n";
+	try
+	{
+		// initialization code
+		//...
+		// init glfw
+		// https://www.glfw.org/documentation.html
+		std::cout << "Initializing GLFW...\n";
+		glfwInit();
+
+		glfwSetErrorCallback(error_callback);
+
+		loadSettings();
+		if (antiAliasingEnabled)
+			glfwWindowHint(GLFW_SAMPLES, antiAliasingSamples);
 
 		// Explicitly request OpenGL 4.6 Compatibility Profile (default-like)
 		std::cout << "Creating window...\n";
@@ -222,91 +380,185 @@ bool App::init()
 	return true;
 }
 
-void App::UpdateLightUniforms(ShaderProgram &shader)
+void App::UpdateFrameUniforms(const glm::mat4 &viewMatrix)
 {
-	GLuint program = shader.getID();
+	CameraData cameraData;
+	cameraData.view = viewMatrix;
+	cameraData.projection = projectionMatrix;
+	cameraData.viewPos = camera.Position;
+
+	LightData lights;
 
 	// Directional light
-	glUniform3fv(glGetUniformLocation(program, "dirLight.direction"), 1, &sun.direction[0]);
-	glUniform3fv(glGetUniformLocation(program, "dirLight.ambient"), 1, &sun.ambient[0]);
-	glUniform3fv(glGetUniformLocation(program, "dirLight.diffuse"), 1, &sun.diffuse[0]);
-	glUniform3fv(glGetUniformLocation(program, "dirLight.specular"), 1, &sun.specular[0]);
+	lights.dirLight.direction = sun.direction;
+	lights.dirLight.ambient = sun.ambient;
+	lights.dirLight.diffuse = sun.diffuse;
+	lights.dirLight.specular = sun.specular;
+	shadowMaps.writeUniforms(lights);
+
+	// Point lights (or the benchmark's light field) and the spot light, culled into clusters
+	frameLights.clear();
+	if (lightBenchmark.enabled)
+	{
+		size_t count = std::min(kLightBenchmarkCounts[lightBenchmark.step], lightBenchmark.lights.size());
+		frameLights.assign(lightBenchmark.lights.begin(), lightBenchmark.lights.begin() + count);
+	}
+	else
+	{
+		for (const PointLight &pointLight : pointLights)
+		{
+			ClusterLight light;
+			light.position = pointLight.position;
+			light.ambient = pointLight.ambient;
+			light.diffuse = pointLight.diffuse;
+			light.specular = pointLight.specular;
+			light.constant = pointLight.constant;
+			light.linear = pointLight.linear;
+			light.quadratic = pointLight.quadratic;
+			light.range = lightRange(light);
+			frameLights.push_back(light);
+		}
+	}
+	if (spotLightEnabled)
+	{
+		ClusterLight light;
+		light.position = spotLight.position;
+		light.direction = spotLight.direction;
+		light.cutOff = spotLight.cutOff;
+		light.outerCutOff = spotLight.outerCutOff;
+		light.ambient = spotLight.ambient;
+		light.diffuse = spotLight.diffuse;
+		light.specular = spotLight.specular;
+		light.range = 0.0f; // Not attenuated.
+		frameLights.push_back(light);
+	}
+
+	auto buildStart = std::chrono::steady_clock::now();
+	lightClusters.setProjection(projectionMatrix, windowWidth, windowHeight);
+	lightClusters.build(viewMatrix, frameLights);
+	lightBenchmark.buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+	clusterLightBuffer.update(frameLights, lightClusters);
 
-	// Point lights
-	for (int i = 0; i < 3; i++)
+	const LightClusters::Settings &grid = lightClusters.config();
+	lights.clusterGrid = glm::uvec4(grid.tilesX, grid.tilesY, grid.slices, static_cast<unsigned>(frameLights.size()));
+	lights.clusterTileSize = lightClusters.tileSize();
+	lights.clusterSliceScale = lightClusters.sliceScale();
+	lights.clusterSliceBias = lightClusters.sliceBias();
+
+	// One write into the persistently mapped buffer replaces ~40 glUniform calls.
+	frameUniformBuffer.update(cameraData, lights);
+}
+
+void App::updateLightBenchmark(double now)
+{
+	if (!lightBenchmark.enabled)
+		return;
+	if (lightBenchmark.stepStart < 0.0)
 	{
-		std::string prefix = "pointLights[" + std::to_string(i) + "].";
-		glUniform3fv(glGetUniformLocation(program, (prefix + "position").c_str()), 1, &pointLights[i].position[0]);
-		glUniform3fv(glGetUniformLocation(program, (prefix + "ambient").c_str()), 1, &pointLights[i].ambient[0]);
-		glUniform3fv(glGetUniformLocation(program, (prefix + "diffuse").c_str()), 1, &pointLights[i].diffuse[0]);
-		glUniform3fv(glGetUniformLocation(program, (prefix + "specular").c_str()), 1, &pointLights[i].specular[0]);
-		glUniform1f(glGetUniformLocation(program, (prefix + "constant").c_str()), pointLights[i].constant);
-		glUniform1f(glGetUniformLocation(program, (prefix + "linear").c_str()), pointLights[i].linear);
-		glUniform1f(glGetUniformLocation(program, (prefix + "quadratic").c_str()), pointLights[i].quadratic);
+		// Uncapped frame rate, or every step would measure the display's refresh interval.
+		vsyncEnabled = false;
+		glfwSwapInterval(0);
+		std::cout << "Light benchmark: " << lightBenchmark.secondsPerStep << " s per step, "
+				  << lightClusters.config().tilesX << "x" << lightClusters.config().tilesY << "x"
+				  << lightClusters.config().slices << " clusters\n";
+		lightBenchmark.stepStart = now;
+		lightBenchmark.frames = 0;
+		lightBenchmark.buildSeconds = 0.0;
+		return;
 	}
 
-	// Spot light
-	glUniform1i(glGetUniformLocation(program, "useSpotLight"), spotLightEnabled);
-	glUniform3fv(glGetUniformLocation(program, "spotLight.position"), 1, &spotLight.position[0]);
-	glUniform3fv(glGetUniformLocation(program, "spotLight.direction"), 1, &spotLight.direction[0]);
-	glUniform1f(glGetUniformLocation(program, "spotLight.cutOff"), spotLight.cutOff);
-	glUniform1f(glGetUniformLocation(program, "spotLight.outerCutOff"), spotLight.outerCutOff);
-	glUniform3fv(glGetUniformLocation(program, "spotLight.ambient"), 1, &spotLight.ambient[0]);
-	glUniform3fv(glGetUniformLocation(program, "spotLight.diffuse"), 1, &spotLight.diffuse[0]);
-	glUniform3fv(glGetUniformLocation(program, "spotLight.specular"), 1, &spotLight.specular[0]);
+	++lightBenchmark.frames;
+	double elapsed = now - lightBenchmark.stepStart;
+	if (elapsed < lightBenchmark.secondsPerStep)
+		return;
+
+	const LightClusters::Stats &clusterStats = lightClusters.stats();
+	std::cout << std::fixed << std::setprecision(3)
+			  << "Lights: " << std::setw(4) << kLightBenchmarkCounts[lightBenchmark.step]
+			  << "  frame " << elapsed * 1000.0 / lightBenchmark.frames << " ms"
+			  << "  cluster build " << lightBenchmark.buildSeconds * 1000.0 / lightBenchmark.frames << " ms"
+			  << "  max " << clusterStats.maxPerCluster << " per cluster, "
+			  << clusterStats.references << " references\n"
+			  << std::defaultfloat;
+
+	lightBenchmark.stepStart = now;
+	lightBenchmark.frames = 0;
+	lightBenchmark.buildSeconds = 0.0;
+	if (++lightBenchmark.step == std::size(kLightBenchmarkCounts))
+	{
+		std::cout << "Light benchmark finished\n";
+		lightBenchmark.enabled = false;
+		lightBenchmark.step = 0;
+	}
 }
 
 void App::init_assets(void)
 {
+	auto assetsStart = std::chrono::steady_clock::now();
 
 	// shader: load, compile, link, initialize params
 	// (may be moved to global variables - if all models use same shader)
 	ShaderProgram my_shader = ShaderProgram("resources/basic.vert", "resources/basic.frag");
 	// ShaderProgram my_transparent_shader = ShaderProgram("resources/tex.vert", "resources/tex.frag");
 	shader_prog_ID = my_shader.getID();
+	mainShader = my_shader;
+	colorUniform = mainShader.uniform("uniform_Color");
+	std::cout << "Shader uniforms reflected: " << mainShader.uniformCount() << "\n";
+
+	// Position-only program for the opaque depth pre-pass
+	renderQueue.setDepthProgram(ShaderProgram("resources/depth.vert", "resources/depth.frag"));
+	renderQueue.setDepthPrepass(depthPrepassEnabled);
+
+	// Depth-only caster program of the sun's shadow cascades
+	shadowMaps.setProgram(ShaderProgram("resources/shadow.vert", "resources/depth.frag"));
+
+	// Weighted blended OIT resolve; "sorted" keeps back-to-front blending
+	renderQueue.setCompositeProgram(ShaderProgram("resources/oit_composite.vert", "resources/oit_composite.frag"));
+	renderQueue.setTransparency(orderIndependentTransparency ? RenderQueue::WEIGHTED_BLENDED_OIT : RenderQueue::SORTED_TRANSPARENCY);
+#if PG2_PROFILER
+	renderQueue.setProfiler(&profiler);
+#endif
 
-	// Define the 5x5 labyrinth layout
-	const int gridSize = 10;
-	int labyrinth[gridSize][gridSize] = {
-		{1, 0, 1, 1, 1, 1, 1, 1, 1, 1},
-		{1, 0, 0, 0, 1, 0, 0, 0, 0, 1},
-		{1, 0, 1, 0, 1, 0, 1, 1, 0, 1},
-		{1, 0, 1, 0, 0, 0, 0, 1, 0, 1},
-		{1, 0, 1, 1, 1, 1, 0, 1, 0, 1},
-		{1, 0, 0, 0, 0, 1, 0, 0, 0, 1},
-		{1, 1, 1, 1, 0, 1, 1, 1, 0, 1},
-		{1, 0, 0, 1, 0, 0, 0, 1, 0, 1},
-		{1, 0, 0, 0, 0, 1, 0, 0, 0, 1},
-		{1, 1, 1, 1, 1, 1, 1, 0, 1, 1}};
+	// Define the labyrinth layout: the hand-made 10x10 one, or a generated maze of any other size
+	const int gridSize = labyrinthSize;
+	std::vector<int> labyrinth = makeLabyrinth(gridSize);
 
 	// Place cubes for each '1' in the labyrinth
 	float cubeSize = 1.0f; // Size of each cube (adjust as needed)
+	models.reserve(models.size() + labyrinth.size() + 16);
 	for (int z = 0; z < gridSize; ++z)
 	{
 		for (int x = 0; x < gridSize; ++x)
 		{
-			if (labyrinth[z][x] == 1)
+			if (labyrinth[z * gridSize + x] == 1)
 			{
 				// Create a cube model at position (x, 0, z)
 				models.emplace_back("resources/objects/cube.obj", my_shader, "resources/textures/box_rgb888.png");
-				models.back().origin = glm::vec3(
-					x * cubeSize - 5.0f, // Center the labyrinth around (0, 0, 0)
-					0.0f,				 // Y = 0 (ground level)
-					z * cubeSize - 5.0f	 // Center the labyrinth
-				);
+				models.back().origin = labyrinthCellOrigin(x, z, gridSize, cubeSize); // Centered around (0, 0, 0)
 			}
 		}
 	}
 
-	// Flat floor for labyrinth (20x20 units to match 10x10 grid of 2-unit cubes)
-	floor.emplace_back(100.0f, 100.0f, my_shader, "resources/textures/StoneFloorTexture.png");
+	// Flat floor for labyrinth
+	float floorSize = labyrinthFloorSize(gridSize, cubeSize);
+	floor.emplace_back(floorSize, floorSize, my_shader, "resources/textures/StoneFloorTexture.png");
 	floor.back().origin = glm::vec3(0.0f, -0.55f, 0.0f); // Slightly below cubes
 
-	// Heightmap terrain (separate, offset to the right)
-	floor.emplace_back("resources/textures/heights.png", my_shader, "resources/textures/StoneFloorTexture.png", 50, 50, 5.0f);
-	floor.back().origin = glm::vec3(0.0f, -0.55f, -50.0f); // Offset 30 units along
+	// Benchmark light field: between the floor and the top of the walls, all over the labyrinth
+	if (lightBenchmark.enabled)
+	{
+		AABB area = floor.back().getWorldBounds();
+		area.min.y = -0.4f;
+		area.max.y = 1.5f;
+		lightBenchmark.lights = generateLightField(kLightBenchmarkCounts[std::size(kLightBenchmarkCounts) - 1], area);
+	}
+
+	// Heightmap terrain (separate, offset to the right), streamed in chunks; 8- or 16-bit PNG or .r16
+	terrain.origin = glm::vec3(0.0f, -0.55f, -50.0f);
+	ShaderProgram terrainShader("resources/terrain.vert", "resources/basic.frag");
+	terrain.load(terrainHeightmap, "resources/textures/StoneFloorTexture.png", terrainShader, terrainSize, terrainSize);
 
-	camera = Camera(glm::vec3(0.0f, 20.0f, -7.0f));
+	camera = Camera(kPlayerStart);
 
 	// Transparent test
 	models.emplace_back("resources/objects/triangle.obj", my_shader, "resources/textures/mirek_vyspely_512.png");
@@ -365,6 +617,7 @@ void App::init_assets(void)
 	models[sunModelIndex].transparent = false;
 
 	// Initialize point lights
+	pointLights.resize(3);
 	pointLights[0].position = glm::vec3(0.0f, 2.0f, 0.0f);
 	pointLights[0].diffuse = glm::vec3(1.0f, 0.0f, 0.0f); // Red light
 	pointLights[0].linear = 0.09f;
@@ -395,6 +648,30 @@ void App::init_assets(void)
 
 	// Initialize cursor position
 	glfwGetCursorPos(window, &cursorLastX, &cursorLastY);
+
+	// Player physics and animation run in the fixed-step simulation
+	initSimulation();
+	simulation.controller.floorHeight = [this](const glm::vec3 &position, float &height)
+	{
+		checkFloorCollision(position, 0.0f, height);
+		return height > -FLT_MAX;
+	};
+
+	// Bounding-volume hierarchy over every drawable model (the vectors do not change after this point)
+	std::vector<Model *> sceneModels;
+	for (auto &model : floor)
+		sceneModels.push_back(&model);
+	for (auto &model : models)
+		sceneModels.push_back(&model);
+	sceneBVH.build(sceneModels);
+
+	// Startup report: a cold start rebuilds the mesh cache, a warm one only maps it.
+	double assetsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - assetsStart).count();
+	std::cout << "Assets loaded in " << assetsMs << " ms ("
+			  << (MeshCache::stats.rebuilds > 0 ? "cold" : "warm") << " mesh cache: "
+			  << MeshCache::stats.hits << " hits in " << MeshCache::stats.loadMs << " ms, "
+			  << MeshCache::stats.rebuilds << " rebuilt in " << MeshCache::stats.buildMs << " ms)\n";
+	AssetManager::instance().printReport();
 }
 
 bool App::checkFloorCollision(const glm::vec3 &position, float playerHalfHeight, float &floorHeight)
@@ -421,18 +698,6 @@ bool App::checkFloorCollision(const glm::vec3 &position, float playerHalfHeight,
 				currentFloorY = floorModel.origin.y + 0.55f;
 			}
 		}
-		else if (floorModel.type == Model::HEIGHTMAP)
-		{
-
-			// Check heightmap collision
-			if (position.x >= floorModel.origin.x - floorModel.width / 4 &&
-				position.x <= floorModel.origin.x + floorModel.width / 4 &&
-				position.z >= floorModel.origin.z - floorModel.depth / 4 &&
-				position.z <= floorModel.origin.z + floorModel.depth / 4)
-			{
-				currentFloorY = floorModel.origin.y + floorModel.getHeightAt(position.x, position.z);
-			}
-		}
 
 		if (currentFloorY > floorHeight)
 		{
@@ -442,28 +707,73 @@ bool App::checkFloorCollision(const glm::vec3 &position, float playerHalfHeight,
 	}
 	// glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
+	if (terrain.contains(position.x, position.z))
+	{
+		floorHeight = std::max(floorHeight, terrain.heightAt(position.x, position.z));
+	}
+
 	return (position.y - playerHalfHeight) <= floorHeight;
 }
 
-bool App::checkObjectCollision(const glm::vec3& position, const glm::vec3& size) {
-	for (auto& model : models) {
-		// Skip transparent models and floor models
-		if (model.transparent) continue;
-
-		// Simple AABB collision check
-		glm::vec3 modelMin = model.origin - glm::vec3(0.5f);
-		glm::vec3 modelMax = model.origin + glm::vec3(0.5f);
-
-		glm::vec3 playerMin = position - size;
-		glm::vec3 playerMax = position + size;
+void App::initSimulation()
+{
+	// Same wall boxes as the cube models placed by init_assets
+	const float cubeSize = 1.0f;
+	simulation.setRate(simulationRate);
+	simulation.collision.build(labyrinthWallBoxes(makeLabyrinth(labyrinthSize), labyrinthSize, cubeSize), cubeSize);
+
+	// Player box around the eye: playerHeight above, twice that below
+	PlayerController &controller = simulation.controller;
+	controller.boxMin = glm::vec3(-camera.playerRadius, -2.0f * camera.playerHeight, -camera.playerRadius);
+	controller.boxMax = glm::vec3(camera.playerRadius, camera.playerHeight, camera.playerRadius);
+	controller.gravity = camera.Gravity;
+	controller.jumpSpeed = camera.JumpForce;
+	controller.floorOffset = camera.playerHeight / 2.0f;
+
+	simulation.reset(camera.Position);
+}
 
-		if (playerMax.x > modelMin.x && playerMin.x < modelMax.x &&
-			playerMax.y > modelMin.y && playerMin.y < modelMax.y &&
-			playerMax.z > modelMin.z && playerMin.z < modelMax.z) {
-			return true;
+int App::simulate(double seconds, double rate)
+{
+	loadSettings();
+	if (rate > 0.0)
+		simulationRate = rate;
+	camera = Camera(kPlayerStart);
+	initSimulation();
+
+	// No floor models without GL: the flat labyrinth floor is reproduced analytically
+	float floorHalfSize = labyrinthFloorSize(labyrinthSize, 1.0f) / 4.0f;
+	simulation.controller.floorHeight = [floorHalfSize](const glm::vec3 &position, float &height)
+	{
+		height = 0.0f;
+		return std::abs(position.x) <= floorHalfSize && std::abs(position.z) <= floorHalfSize;
+	};
+
+	// Scripted input: a new walking direction every 2 seconds, a jump every 3 seconds
+	const uint64_t steps = static_cast<uint64_t>(std::llround(seconds * simulationRate));
+	const uint64_t stepsPerSecond = static_cast<uint64_t>(std::llround(simulationRate));
+	uint64_t trace = 1469598103934665603ull;
+	std::cout << std::setprecision(9);
+	for (uint64_t i = 0; i < steps; ++i)
+	{
+		double time = static_cast<double>(i) / simulationRate;
+		float heading = glm::radians(90.0f * static_cast<float>(static_cast<int>(time / 2.0)) + 30.0f);
+		PlayerController::Input input;
+		input.wishVelocity = glm::vec3(std::cos(heading), 0.0f, std::sin(heading)) * camera.MovementSpeed;
+		input.jump = std::fmod(time, 3.0) < 0.1;
+		simulation.step(input);
+
+		const SimulationState &state = simulation.state();
+		trace = (trace ^ state.hash()) * 1099511628211ull;
+		if (state.tick % stepsPerSecond == 0 || i + 1 == steps)
+		{
+			std::cout << "t=" << static_cast<double>(state.tick) * simulation.stepSeconds()
+					  << " pos " << state.player.position.x << " " << state.player.position.y << " " << state.player.position.z
+					  << " vy " << state.player.velocity.y << (state.player.grounded ? " grounded" : "") << "\n";
 		}
 	}
-	return false;
+	std::cout << "steps " << steps << " at " << simulationRate << " Hz, trace hash " << std::hex << trace << std::dec << "\n";
+	return EXIT_SUCCESS;
 }
 
 int App::run(void)
@@ -481,18 +791,21 @@ int App::run(void)
 
 		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-		GLint uniform_color_location = glGetUniformLocation(shader_prog_ID, "uniform_Color");
-		if (uniform_color_location == -1)
+		if (!colorUniform.valid())
 		{
 			std::cerr << "Uniform 'uniform_Color' not found.\n";
 		}
 
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+		simulationThread.start(simulation);
+
 		while (!glfwWindowShouldClose(window))
 		{
+#if PG2_PROFILER
+			profiler.beginFrame();
+#endif
 			double currentTime = glfwGetTime();
-			float deltaTime = static_cast<float>(currentTime - lastFrameTime);
 			lastFrameTime = currentTime;
 			float totalTime = static_cast<float>(currentTime - startTime);
 
@@ -501,211 +814,158 @@ int App::run(void)
 			if (currentTime - lastFpsUpdate >= 1.0)
 			{
 				double fps = frameCount / (currentTime - lastFpsUpdate);
+				std::ostringstream profile;
+				profile << std::fixed << std::setprecision(2);
+#if PG2_PROFILER
+				// Frame times over the profiler's window
+				FrameProfiler::Report report = profiler.report();
+				profile << " | CPU: " << report.cpuFrame.avg << " ms (p99 " << report.cpuFrame.p99 << ")"
+						<< " | GPU: " << report.gpuFrame.avg << " ms (p99 " << report.gpuFrame.p99 << ")";
+#endif
+				// GPU time of each shadow cascade, newest measured frame
+				profile << " | Shadows: ";
+				for (int i = 0; i < shadowMaps.cascadeCount(); ++i)
+					profile << (i > 0 ? "/" : "") << shadowMaps.stats().gpuMs[i];
+				profile << (shadowMaps.cascadeCount() > 0 ? " ms" : "Off");
 				std::string title = "FPS: " + std::to_string(static_cast<int>(fps + 0.5)) +
-									" | VSync: " + (vsyncEnabled ? "On" : "Off");
+									" | VSync: " + (vsyncEnabled ? "On" : "Off") +
+									" | Visible: " + std::to_string(cameraCullStats.visible) +
+									" Culled: " + std::to_string(cameraCullStats.culled) +
+									" | Draws: " + std::to_string(renderQueue.stats().draws) +
+									" (" + std::to_string(renderQueue.stats().packets) + " meshes)" +
+									" | Binds saved: " + std::to_string(renderQueue.stats().bindsSaved) +
+									" | Z-prepass: " + (renderQueue.depthPrepass() ? "On" : "Off") +
+									" | Transparency: " + (renderQueue.transparencyMode() == RenderQueue::WEIGHTED_BLENDED_OIT ? "OIT" : "Sorted") +
+									" | FS invocations: " + std::to_string(renderQueue.stats().depthFragments >> 10) + "k depth, " +
+									std::to_string(renderQueue.stats().opaqueFragments >> 10) + "k opaque, " +
+									std::to_string(renderQueue.stats().transparentFragments >> 10) + "k transparent" +
+									profile.str() +
+									" | Sim: " + std::to_string(static_cast<int>(simulationRate)) + " Hz" +
+									" | Terrain: " + std::to_string(terrain.stats().residentChunks) + " chunks, " +
+									std::to_string(terrain.stats().residentBytes() >> 20) + " MB, " +
+									std::to_string(terrain.stats().trianglesDrawn) + " tris";
 				glfwSetWindowTitle(window, title.c_str());
 				frameCount = 0;
 				lastFpsUpdate = currentTime;
 			}
 
-			float angle = totalTime * 15.0f;
-			sun.direction = glm::normalize(glm::vec3(
-				sin(glm::radians(angle)),
-				cos(glm::radians(angle)),
-				0.0f));
-
-			float sunHeight = sun.direction.y;
+			// Swap in textures that finished loading in the background
+			PG2_PROFILE_BEGIN(profiler, FrameProfiler::INPUT_PHASE);
+			AssetManager::instance().updateTextures();
+
+			// Hand the input to the simulation thread and show the scene between its two newest steps
+			PlayerController::Input input;
+			input.wishVelocity = camera.ProcessInput(window, input.jump);
+			simulationThread.setInput(input);
+			SimulationState previousState, currentState;
+			float alpha = simulationThread.sample(previousState, currentState);
+			SimulationState state = SimulationState::interpolate(previousState, currentState, alpha);
+			camera.Position = state.player.position;
+			camera.Velocity = currentState.player.velocity;
+			camera.isGrounded = currentState.player.grounded;
+
+			// The simulation gives the direction towards the sun; its light travels the other way
+			sun.direction = -state.sunDirection;
+			float sunHeight = state.sunDirection.y;
 			sun.ambient = glm::vec3(0.2f) * (0.75f + 0.75f * sunHeight);
 			sun.diffuse = glm::vec3(0.5f) * (0.75f + 0.75f * sunHeight);
+			models[sunModelIndex].origin = state.sunDirection * simulation.sunDistance;
 
-			// Update sun model position
-			float distance = 20.0f; // Closer sun
-			glm::vec3 sunPosition = sun.direction * distance;
-			models[sunModelIndex].origin = sunPosition;
-
-			// std::cout << "sun.direction.y: " << sun.direction.y << ", ambient: " << sun.ambient.x << ", diffuse: " << sun.diffuse.x << std::endl;
-
-			// Animate spheres (orbiting only, no rotation)
-			float angle1 = totalTime * 1.0f;
-			models[sphere1Index].origin.x = -2.0f + 3.0f * cos(angle1);
-			models[sphere1Index].origin.z = 0.0f + 3.0f * sin(angle1);
-			models[sphere1Index].origin.y = 7.0f;
-
-			float angle2 = totalTime * 1.5f + 2.0f * 3.1415926535f / 3.0f;
-			models[sphere2Index].origin.x = -2.0f + 3.0f * cos(angle2);
-			models[sphere2Index].origin.y = 7.0f + 3.0f * sin(angle2);
-			models[sphere2Index].origin.z = 0.0f;
-
-			float angle3 = totalTime * 2.0f + 4.0f * 3.1415926535f / 3.0f;
-			models[sphere3Index].origin.y = 7.0f + 3.0f * cos(angle3);
-			models[sphere3Index].origin.z = 0.0f + 3.0f * sin(angle3);
-			models[sphere3Index].origin.x = -2.0f;
+			models[sphere1Index].origin = state.sphereOrigins[0];
+			models[sphere2Index].origin = state.sphereOrigins[1];
+			models[sphere3Index].origin = state.sphereOrigins[2];
+			PG2_PROFILE_END(profiler, FrameProfiler::INPUT_PHASE);
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			glm::vec3 movement = camera.ProcessInput(window, deltaTime);
-			glm::vec3 newPosition = camera.Position + movement;
-
-			// Player collision parameters
-			const float playerHalfHeight = camera.playerHeight / 2.0f;
-			const glm::vec3 playerSize(camera.playerRadius, camera.playerHeight, camera.playerRadius);
-
-			// Floor collision
-			float floorHeight;
-			if (checkFloorCollision(newPosition, playerHalfHeight, floorHeight))
-			{
-				// Snap to floor and stop vertical movement
-				newPosition.y = floorHeight + playerHalfHeight;//camera.playerHeight;
-				camera.Velocity.y = 0.0f;
-				camera.isGrounded = true;
-			}
-			else
-			{
-				camera.isGrounded = false;
-			}
-
-			// Object collision checks (separate axes)
-			bool collisionX = checkObjectCollision(glm::vec3(newPosition.x, camera.Position.y, camera.Position.z), playerSize);
-			//bool collisionY = checkObjectCollision(glm::vec3(camera.Position.x, newPosition.y, camera.Position.z), playerSize);
-			bool collisionZ = checkObjectCollision(glm::vec3(camera.Position.x, camera.Position.y, newPosition.z), playerSize);
-
-			bool collisionY = false;
-			float highestCollisionY = -INFINITY;
-			glm::vec3 yCheckPos(camera.Position.x, newPosition.y, camera.Position.z);
-			for (auto& model : models) {
-				if (model.transparent) continue;
-
-				glm::vec3 modelMin = model.origin - glm::vec3(0.5f);
-				glm::vec3 modelMax = model.origin + glm::vec3(0.5f);
-
-				glm::vec3 playerMin = yCheckPos - glm::vec3(0.0f, 2*camera.playerHeight, 0.0f);
-				glm::vec3 playerMax = yCheckPos + playerSize; // + glm::vec3(0.0f, camera.playerHeight, 0.0f);
-
-				bool overlapX = (playerMax.x > modelMin.x && playerMin.x < modelMax.x);
-				bool overlapY = (playerMax.y > modelMin.y && playerMin.y < modelMax.y);
-				bool overlapZ = (playerMax.z > modelMin.z && playerMin.z < modelMax.z);
-
-				bool overlap = overlapX && overlapY && overlapZ;
-
-				if (overlap) {
-					collisionY = true;
-					if (modelMax.y > highestCollisionY) {
-						highestCollisionY = modelMax.y + camera.playerHeight;
-					}
-				}
-			}
-
-			// Handle Y-axis collision
-			if (collisionY) {
-				if (camera.Velocity.y < 0.0f) {
-					// Land on the object's top
-					newPosition.y = highestCollisionY + camera.playerHeight;// + camera.playerHeight;
-					camera.isGrounded = true;
-					camera.Velocity.y = 0.0f;
-				} else {
-					// Collision from below (ceiling)
-					newPosition.y = camera.Position.y;
-					camera.Velocity.y = 0.0f;
-				}
-			}
-
-			if (collisionX) newPosition.x = camera.Position.x;
-			if (collisionZ) newPosition.z = camera.Position.z;
-
-			// Update final camera position
-			camera.Position = newPosition;
-
 			// Update spot light to follow camera
 			spotLight.position = camera.Position;
 			spotLight.direction = camera.Front;
 
-			// Update all light uniforms
-			UpdateLightUniforms(models[0].shader); // Assuming first model has the shader
+			// Update camera and light blocks (one write shared by all programs)
+			PG2_PROFILE_BEGIN(profiler, FrameProfiler::UNIFORMS_PHASE);
+			glm::mat4 viewMatrix = camera.GetViewMatrix();
+			bool sunShadows = shadowMaps.fit(viewMatrix, projectionMatrix, sun.direction);
+			UpdateFrameUniforms(viewMatrix);
 
 			glUseProgram(shader_prog_ID);
 
-			if (uniform_color_location != -1)
-				glUniform4f(uniform_color_location, r, g, b, a);
+			mainShader.setUniform(colorUniform, glm::vec4(r, g, b, a));
+			PG2_PROFILE_END(profiler, FrameProfiler::UNIFORMS_PHASE);
 
-			// Update view and projection matrices
-			glm::mat4 viewMatrix = camera.GetViewMatrix();
-			glUniformMatrix4fv(glGetUniformLocation(shader_prog_ID, "uV_m"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
-			glUniformMatrix4fv(glGetUniformLocation(shader_prog_ID, "uP_m"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-
-			// Draw floor
-			// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			// Update models
+			PG2_PROFILE_BEGIN(profiler, FrameProfiler::CULL_PHASE);
 			for (auto &model : floor)
 			{
 				model.update(totalTime);
-				model.draw();
 			}
-			// glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-			// Update view position
-			glm::vec3 cameraPos = camera.Position;
-			GLint viewPosLoc = glGetUniformLocation(shader_prog_ID, "viewPos");
-			if (viewPosLoc != -1)
-				glUniform3fv(viewPosLoc, 1, glm::value_ptr(cameraPos));
-
-			// Update sun uniforms
-			GLint sunDirLoc = glGetUniformLocation(shader_prog_ID, "sun.direction");
-			if (sunDirLoc != -1)
-				glUniform3fv(sunDirLoc, 1, glm::value_ptr(sun.direction));
-
-			GLint sunAmbientLoc = glGetUniformLocation(shader_prog_ID, "sun.ambient");
-			if (sunAmbientLoc != -1)
-				glUniform3fv(sunAmbientLoc, 1, glm::value_ptr(sun.ambient));
-
-			GLint sunDiffuseLoc = glGetUniformLocation(shader_prog_ID, "sun.diffuse");
-			if (sunDiffuseLoc != -1)
-				glUniform3fv(sunDiffuseLoc, 1, glm::value_ptr(sun.diffuse));
-
-			GLint sunSpecularLoc = glGetUniformLocation(shader_prog_ID, "sun.specular");
-			if (sunSpecularLoc != -1)
-				glUniform3fv(sunSpecularLoc, 1, glm::value_ptr(sun.specular));
-
-			// Update models
 			for (auto &model : models)
 			{
 				model.update(totalTime);
 			}
 
-			// Draw non-transparent models
-			std::vector<Model *> transparentModels;
-			for (auto &model : models)
+			// Follow moved models, then keep only what intersects the view frustum
+			sceneBVH.refit();
+			visibleModels.clear();
+			Frustum frustum(projectionMatrix * viewMatrix);
+			sceneBVH.cull(frustum, visibleModels);
+			cameraCullStats = sceneBVH.stats();
+			PG2_PROFILE_END(profiler, FrameProfiler::CULL_PHASE);
+
+			// Sun shadows: each cascade draws the opaque models inside its light-space box
+			if (sunShadows)
 			{
-				if (!model.transparent)
-				{
-					model.draw();
-				}
-				else
+				for (int i = 0; i < shadowMaps.cascadeCount(); ++i)
 				{
-					transparentModels.push_back(&model);
+					PG2_PROFILE_SCOPE(profiler, static_cast<FrameProfiler::Phase>(FrameProfiler::SHADOW_PHASE + i));
+					shadowCasters.clear();
+					sceneBVH.cull(Frustum(shadowMaps.cascade(i).viewProjection), shadowCasters);
+					shadowMaps.begin(i);
+					shadowQueue.begin(camera.Position);
+					for (Model *model : shadowCasters)
+					{
+						if (!model->transparent && !model->isSun)
+							shadowQueue.submit(*model, RenderQueue::OPAQUE_PASS);
+					}
+					shadowQueue.flushDepth(shadowMaps.program());
+					shadowMaps.end(i);
 				}
+				shadowMaps.finish(windowWidth, windowHeight);
 			}
 
-			// Sort and draw transparent models
-			std::sort(transparentModels.begin(), transparentModels.end(), [&](Model *a, Model *b)
-					  {
-                glm::vec3 posA = a->origin;
-                glm::vec3 posB = b->origin;
-                return glm::distance(camera.Position, posA) > glm::distance(camera.Position, posB); });
-
-			glEnable(GL_BLEND);
-			glDepthMask(GL_FALSE);
-			for (auto &model : transparentModels)
+			// Queue the visible models and let the render queue order them: opaque by state
+			// and front-to-back, transparent after all opaque geometry (OIT or back-to-front)
+			renderQueue.begin(camera.Position);
+			for (Model *model : visibleModels)
 			{
-				model->draw();
+				renderQueue.submit(*model, model->transparent ? RenderQueue::TRANSPARENT_PASS : RenderQueue::OPAQUE_PASS);
 			}
-			glDepthMask(GL_TRUE);
-			glDisable(GL_BLEND);
+			PG2_PROFILE_BEGIN(profiler, FrameProfiler::TERRAIN_PHASE);
+			terrain.update(camera.Position);
+			terrain.draw(frustum, camera.Position);
+			PG2_PROFILE_END(profiler, FrameProfiler::TERRAIN_PHASE);
+			renderQueue.flush();
+
+			frameUniformBuffer.endFrame();
+			updateLightBenchmark(currentTime);
 
+			PG2_PROFILE_BEGIN(profiler, FrameProfiler::SWAP_PHASE);
 			glfwPollEvents();
 			glfwSwapBuffers(window);
+			PG2_PROFILE_END(profiler, FrameProfiler::SWAP_PHASE);
+#if PG2_PROFILER
+			profiler.endFrame();
+#endif
 		}
+		simulationThread.stop();
+#if PG2_PROFILER
+		profiler.finish();
+		profiler.print(std::cout);
+#endif
 	}
 	catch (const std::exception &e)
 	{
+		simulationThread.stop();
 		std::cerr << "App failed: " << e.what() << std::endl;
 		return EXIT_FAILURE;
 	}
@@ -824,6 +1084,20 @@ void App::key_callback(GLFWwindow *window, int key, int scancode, int action, in
 		case GLFW_KEY_L:
 			spotLightEnabled = !spotLightEnabled;
 			break;
+		case GLFW_KEY_P:
+			renderQueue.setDepthPrepass(!renderQueue.depthPrepass());
+			std::cout << "Depth pre-pass " << (renderQueue.depthPrepass() ? "on" : "off") << std::endl;
+			break;
+		case GLFW_KEY_O:
+			orderIndependentTransparency = !orderIndependentTransparency;
+			renderQueue.setTransparency(orderIndependentTransparency ? RenderQueue::WEIGHTED_BLENDED_OIT : RenderQueue::SORTED_TRANSPARENCY);
+			std::cout << "Transparency: " << (orderIndependentTransparency ? "weighted blended OIT" : "sorted") << std::endl;
+			break;
+#if PG2_PROFILER
+		case GLFW_KEY_F3:
+			profiler.print(std::cout);
+			break;
+#endif
 		default:
 			break;
 		}
@@ -859,8 +1133,27 @@ void App::mouse_button_callback(GLFWwindow *window, int button, int action, int
 App::~App()
 {
 	// clean-up
+	// The simulation reads the floor models, so it stops before they go away.
+	simulationThread.stop();
+
+	// Release shared meshes and textures while the GL context still exists (none in headless runs).
 	if (window)
+	{
+		renderQueue.clear();
+		shadowQueue.clear();
+#if PG2_PROFILER
+		profiler.clear();
+#endif
+		shadowMaps.clear();
+		terrain.clear();
+		frameUniformBuffer.clear();
+		clusterLightBuffer.clear();
+		MaterialBuffer::instance().clear();
+		models.clear();
+		floor.clear();
+		AssetManager::instance().clear();
 		glfwDestroyWindow(window);
+	}
 	glfwTerminate();
 
 	// cleanup GL data
@@ -5,7 +5,15 @@
 #include <GLFW/glfw3.h> // GLFW comes after GLEW
 #include "camera.hpp"
 #include <glm/glm.hpp>
+#include "FrameProfiler.hpp"
+#include "LightClusters.hpp"
 #include "Model.hpp"
+#include "RenderQueue.hpp"
+#include "SceneBVH.hpp"
+#include "ShadowMaps.hpp"
+#include "Simulation.hpp"
+#include "Terrain.hpp"
+#include "UniformBlocks.hpp"
 #include <string>
 #include <vector>
 
@@ -18,6 +26,10 @@ public:
     void init_assets();
     int run();
 
+    // Headless fixed-step run of the player and scene animation with scripted input; prints the
+    // trajectory and a hash of every state. rate <= 0 uses the rate from app_settings.json.
+    int simulate(double seconds, double rate = 0.0);
+
     // Callbacks
     static void error_callback(int error, const char *description);
     void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
@@ -26,7 +38,6 @@ public:
     void framebuffer_size_callback(GLFWwindow *window, int width, int height);
     void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
     bool checkFloorCollision(const glm::vec3 &position, float playerHalfHeight, float &floorHeight);
-    bool checkObjectCollision(const glm::vec3& position, const glm::vec3& size);
     void toggleFullscreen();
     size_t sphere1Index;
     size_t sphere2Index;
@@ -89,10 +100,29 @@ public:
     size_t sunModelIndex;
 
 private:
-    GLFWwindow *window;
+    void loadSettings();
+    void initSimulation();
+
+    GLFWwindow *window = nullptr;
     GLuint shader_prog_ID;
     std::vector<Model> models;
     std::vector<Model> floor;
+    RenderQueue renderQueue;    // Sorts and batches all draws of a frame
+    bool depthPrepassEnabled = true; // Depth-only pass before shading the opaque packets (P toggles)
+    bool orderIndependentTransparency = true; // Weighted blended OIT, else sorted blending (O toggles)
+    SceneBVH sceneBVH;          // Culling hierarchy over floor and models
+    std::vector<Model *> visibleModels;
+    SceneBVH::Stats cameraCullStats; // Camera cull of the last frame (the cascades cull afterwards)
+    ShadowMaps shadowMaps;      // Cascaded shadow maps of the sun
+    RenderQueue shadowQueue;    // Casters of one cascade at a time
+    std::vector<Model *> shadowCasters;
+    Simulation simulation;                   // Fixed-step player physics and animation
+    SimulationThread simulationThread;       // Steps the simulation independently of rendering
+    double simulationRate = Simulation::kDefaultRate; // Steps per second
+    int labyrinthSize = 10;     // Cells per side; 10 uses the hand-made layout
+    Terrain terrain;            // Chunked heightmap terrain (drawn outside the render queue)
+    std::string terrainHeightmap = "resources/textures/heights.png";
+    int terrainSize = 50;       // Samples per side the heightmap is resized to (0 keeps the image size)
     float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
     bool vsyncEnabled = true;
     bool antiAliasingEnabled = false; // default value
@@ -118,11 +148,41 @@ private:
     int resX;            // Stores default_resolution.x (1024)
     int resY;            // Stores default_resolution.y (768)
 
-    PointLight pointLights[3]; // Array for 3 point lights
-    SpotLight spotLight;       // Single spot light
+    std::vector<PointLight> pointLights; // Scene point lights (any number)
+    SpotLight spotLight;                 // Flashlight following the camera
     bool spotLightEnabled = true;
 
-    void UpdateLightUniforms(ShaderProgram &shader);
+    // Point and spot lights are bucketed into view-space clusters each frame; basic.frag
+    // shades a fragment with only the lights of its cluster.
+    LightClusters lightClusters;
+    ClusterLightBuffer clusterLightBuffer;
+    std::vector<ClusterLight> frameLights;
+
+    // Light scaling benchmark ("lights": {"benchmark": true}): replaces the scene lights with a
+    // field of kLightBenchmarkCounts[step] lights over the labyrinth and logs the frame time of each step.
+    static constexpr size_t kLightBenchmarkCounts[] = {3, 8, 16, 32, 64, 128, 256, 512, 1024};
+    struct LightBenchmark
+    {
+        bool enabled = false;
+        double secondsPerStep = 3.0;
+        size_t step = 0;
+        double stepStart = -1.0; // Negative until the first measured frame.
+        int frames = 0;
+        double buildSeconds = 0.0; // Cluster build time summed over the step's frames.
+        std::vector<ClusterLight> lights;
+    } lightBenchmark;
+    void updateLightBenchmark(double now);
+
+#if PG2_PROFILER
+    FrameProfiler profiler; // CPU and GPU time per frame phase (F3 prints the window's statistics)
+#endif
+
+    // Camera and lights are shared with every program through uniform blocks.
+    FrameUniformBuffer frameUniformBuffer;
+    ShaderProgram mainShader;
+    UniformHandle colorUniform; // uniform_Color, if the shader has it
+
+    void UpdateFrameUniforms(const glm::mat4 &viewMatrix);
 
     bool isFullscreen = false;
     int windowPosX = 100, windowPosY = 100;        // default starting position
@@ -44,7 +44,9 @@ public:
     }
 
 
-    glm::vec3 ProcessInput(GLFWwindow *window, GLfloat deltaTime)
+    // Horizontal velocity requested by the keyboard and whether jump is held.
+    // Integration and collisions are done by PlayerController.
+    glm::vec3 ProcessInput(GLFWwindow *window, bool &jump)
     {
         glm::vec3 inputDirection(0.0f);
         
@@ -60,25 +62,8 @@ public:
         if (glm::length(inputDirection) > 0.0f)
             inputDirection = glm::normalize(inputDirection) * MovementSpeed;
 
-        // Jump only if grounded
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && isGrounded) {
-            Velocity.y = JumpForce;
-            isGrounded = false;
-        }
-
-        // Apply movement speed only if there's input
-        //if (glm::length(inputDirection) > 0.0f) {
-        //    inputDirection = glm::normalize(inputDirection) * MovementSpeed;
-        //}
-
-        // Apply gravity
-        Velocity.y += Gravity * deltaTime;
-        
-        // Update position based on velocity
-        glm::vec3 movement = inputDirection * deltaTime;
-        movement.y = Velocity.y * deltaTime;
-        
-        return movement;
+        jump = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        return inputDirection;
     }
 
     void ProcessMouseMovement(GLfloat xoffset, GLfloat yoffset, GLboolean constrainPitch = GL_TRUE)
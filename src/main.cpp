@@ -1,12 +1,32 @@
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include "app.hpp"
 
-int main()
+int main(int argc, char **argv)
 {
+    // Headless regression run: pg2_project --simulate SECONDS [--rate HZ]
+    double simulateSeconds = -1.0;
+    double simulateRate = 0.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--simulate" && i + 1 < argc)
+            simulateSeconds = std::atof(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc)
+            simulateRate = std::atof(argv[++i]);
+    }
+
     std::cout << "Entering main...\n" << std::flush;
     try
     {
+        if (simulateSeconds >= 0.0)
+        {
+            App app;
+            return app.simulate(simulateSeconds, simulateRate);
+        }
+
         // define our application
         std::cout << "Creating App object...\n" << std::flush;
         App app;
@@ -0,0 +1,48 @@
+// Offline converter: OBJ -> .pgmesh (welded, cache-optimized, GPU-ready).
+//
+// Usage:
+//   pg2_meshconv [--cache-dir DIR] input.obj...   writes the runtime cache entries (default cache/meshes)
+//   pg2_meshconv -o output.pgmesh input.obj       writes a single file to an explicit path
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MeshCache.hpp"
+
+int main(int argc, char **argv)
+{
+	std::filesystem::path cacheDir = MeshCache::defaultDirectory;
+	std::filesystem::path output;
+	std::vector<std::filesystem::path> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--cache-dir" && i + 1 < argc)
+			cacheDir = argv[++i];
+		else if (arg == "-o" && i + 1 < argc)
+			output = argv[++i];
+		else
+			inputs.push_back(arg);
+	}
+
+	if (inputs.empty() || (!output.empty() && inputs.size() != 1))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--cache-dir DIR] input.obj...\n"
+				  << "       " << argv[0] << " -o output.pgmesh input.obj\n";
+		return EXIT_FAILURE;
+	}
+
+	int failures = 0;
+	for (const auto &input : inputs)
+	{
+		std::filesystem::path target = output.empty() ? MeshCache::entryPath(input, cacheDir) : output;
+		if (MeshCache::build(input, target))
+			std::cout << input.string() << " -> " << target.string() << "\n";
+		else
+			++failures;
+	}
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
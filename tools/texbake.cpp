@@ -0,0 +1,65 @@
+// Offline texture baker: image -> .pgtex (precomputed mip chain, BC1/BC3 or RGBA8).
+//
+// Usage:
+//   pg2_texbake [--format auto|bc1|bc3|rgba8] [--cache-dir DIR] image...   writes the runtime cache entries (default cache/textures)
+//   pg2_texbake [--format ...] -o output.pgtex image                        writes a single file to an explicit path
+//
+// "auto" (the default) picks BC1 for opaque images and BC3 for images with alpha.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TextureBake.hpp"
+
+int main(int argc, char **argv)
+{
+	std::filesystem::path cacheDir = kTextureCacheDirectory;
+	std::filesystem::path output;
+	std::vector<std::filesystem::path> inputs;
+	TextureFileFormat format = TextureFileFormat::BC1;
+	bool automatic = true;
+	bool valid = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--cache-dir" && i + 1 < argc)
+			cacheDir = argv[++i];
+		else if (arg == "-o" && i + 1 < argc)
+			output = argv[++i];
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			std::string name = argv[++i];
+			automatic = name == "auto";
+			if (name == "bc1")
+				format = TextureFileFormat::BC1;
+			else if (name == "bc3")
+				format = TextureFileFormat::BC3;
+			else if (name == "rgba8")
+				format = TextureFileFormat::RGBA8;
+			else if (!automatic)
+				valid = false;
+		}
+		else
+			inputs.push_back(arg);
+	}
+
+	if (!valid || inputs.empty() || (!output.empty() && inputs.size() != 1))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--format auto|bc1|bc3|rgba8] [--cache-dir DIR] image...\n"
+				  << "       " << argv[0] << " [--format auto|bc1|bc3|rgba8] -o output.pgtex image\n";
+		return EXIT_FAILURE;
+	}
+
+	int failures = 0;
+	for (const auto &input : inputs)
+	{
+		std::filesystem::path target = output.empty() ? bakedTexturePath(input, cacheDir) : output;
+		if (bakeTexture(input, target, format, automatic))
+			std::cout << input.string() << " -> " << target.string() << "\n";
+		else
+			++failures;
+	}
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}